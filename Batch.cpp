@@ -0,0 +1,1404 @@
+// ------------------------------------------------------------------------------------------------
+#include "Batch.hpp"
+#include "BulkReader.hpp"
+#include "Parser.hpp"
+#include "Builder.hpp"
+#include "Template.hpp"
+#include "Columns.hpp"
+#include "Diff.hpp"
+#include "Parallel.hpp"
+#include "Queue.hpp"
+#include "InstanceCache.hpp"
+#include "SpatialIndex.hpp"
+#include "Watcher.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+// ------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+namespace fs = std::filesystem;
+
+// ------------------------------------------------------------------------------------------------
+const size_t StreamBatch = 16384; // Instances handed from one stage to the next when streaming
+const size_t StreamDepth = 4; // Batches waiting between two stages when streaming
+
+/* ------------------------------------------------------------------------------------------------
+ * An output generated from the instances and the file it goes to.
+*/
+struct Target
+{
+    // --------------------------------------------------------------------------------------------
+    Format      mFormat; // The kind of output to generate
+    std::string mTemplate; // Custom output template (overrides the format)
+    std::string mPath; // Output file path (empty for standard output)
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Options received from the command line.
+*/
+struct Options
+{
+    // --------------------------------------------------------------------------------------------
+    Format                      mFormat = Format::NUT; // The kind of output to generate
+    std::string                 mFunc = "HideMapObject"; // Function name used in scripts
+    std::string                 mTemplate; // Custom output template (overrides the format)
+    std::string                 mOutput; // Output file path (empty for standard output)
+    unsigned                    mJobs = 0; // Number of workers (0 for automatic)
+    bool                        mDiagnostics = false; // Report problems and timings as JSON
+    std::string                 mCache; // Where parsed files are cached (empty for nowhere)
+    bool                        mWatch = false; // Regenerate the output when the inputs change
+    bool                        mStream = false; // Pass instances through in batches
+    double                      mGridSize = DefaultGridSize; // Size of the map cells in grids
+    // --------------------------------------------------------------------------------------------
+    std::vector< std::string >  mBase; // Previous version of the inputs to compare against
+    std::string                 mRemoved; // Output of the removed instances (empty for none)
+    std::string                 mShowFunc = "ShowMapObject"; // Function for removed instances
+    std::vector< std::string >  mInputs; // Files and directories to process
+    std::vector< Target >       mTargets; // Every output generated from the same instances
+    // --------------------------------------------------------------------------------------------
+    std::string                 mIndexIn; // Spatial index to load instead of parsing files
+    std::string                 mIndexOut; // Where to save the spatial index of the inputs
+    double                      mCellSize = 50.0; // Size of the spatial index cells
+    SpatialIndex::Query         mQuery; // Conditions that emitted instances must meet
+    Filter                      mFilter; // Conditions checked without going through the index
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether any query conditions were specified.
+    */
+    bool HasQuery() const
+    {
+        return mQuery.mSphere || mFilter.Enabled();
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether the instances must go through a spatial index.
+    */
+    bool Indexed() const
+    {
+        return mQuery.mSphere || !mIndexIn.empty() || !mIndexOut.empty();
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether the output of the specified target needs the instances of every file at once.
+    */
+    bool Joined(const Target & target) const
+    {
+        return Indexed() || IsBinary(target.mFormat) || IsGrid(target.mFormat) || !mBase.empty();
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether the output of any target needs the instances of every file at once.
+    */
+    bool Joined() const
+    {
+        return std::any_of(mTargets.begin(), mTargets.end(), [this](const Target & t) {
+            return Joined(t);
+        });
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether saving the spatial index is the only thing to do.
+    */
+    bool IndexOnly() const
+    {
+        return !HasQuery() && !mIndexOut.empty();
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Generates the output of the specified instances.
+*/
+typedef std::function< bool (const Instances & inst_list, Writer & out) > Generator;
+
+/* ------------------------------------------------------------------------------------------------
+ * The work associated with a single input file.
+*/
+struct Task
+{
+    // --------------------------------------------------------------------------------------------
+    std::string             mPath; // Path of the input file
+    Instances               mInstances; // Extracted instances (only kept when generated at once)
+    std::vector< Writer >   mOutputs; // Generated output of every target
+    Diagnostics             mDiagnostics; // Reported problems and timings
+    bool                    mFailed = false; // Whether the file could not be processed
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Display the command line usage.
+*/
+void Usage(const char * exe)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options] <files/directories...>\n"
+        "  -f, --format <name>             The kind of output to generate (default: nut)\n"
+        "                                  nut, raw, xml, bin or script tables: tnut, traw, delta\n"
+        "                                  or script tables by map cell: gnut, graw\n"
+        "      --func <name>               Function name used in scripts (default: HideMapObject)\n"
+        "  -t, --template <pattern>        Generate each instance from a custom template\n"
+        "  -o, --output <path>             Write the output to a file instead of standard output\n"
+        "  -e, --emit <name>=<path>        Also write another format to a file (repeatable)\n"
+        "  -j, --jobs <count>              Files processed in parallel (default: all cores)\n"
+        "      --diagnostics               Report problems and timings as JSON on standard error\n"
+        "      --cache <dir>               Keep parsed files in a directory to skip parsing them\n"
+        "  -w, --watch                     Keep running and update the output when inputs change\n"
+        "      --stream                    Parse, generate and write in batches with fixed memory\n"
+        "      --grid-size <units>         Size of the map cells of gnut and graw (default: 250)\n"
+        "  -h, --help                      Display this message\n"
+        "Comparison:\n"
+        "      --diff <path>               Only emit instances missing from a previous version\n"
+        "      --removed <path>            Write instances missing from the inputs to a file\n"
+        "      --show-func <name>          Function used for removed instances (default: "
+                                            "ShowMapObject)\n"
+        "Spatial index:\n"
+        "      --index <path>              Query a saved index instead of parsing files\n"
+        "      --save-index <path>         Save the index of the parsed files\n"
+        "      --cell-size <units>         Size of the index cells (default: 50)\n"
+        "      --box <x,y,z,x,y,z>         Only emit instances inside a box (two corners)\n"
+        "      --near <x,y,z,radius>       Only emit instances within a distance of a point\n"
+        "      --model <id[,id...]>        Only emit instances of the specified models\n"
+        "      --deny <id[,id...]>         Never emit instances of the specified models\n"
+        "      --z-range <min,max>         Only emit instances within a range of heights\n"
+        "Directories are searched recursively for *.ipl files.\n", exe);
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * See whether the argument is the specified option, in either the short or the long form.
+*/
+inline bool Is(const char * arg, const char * sopt, const char * lopt)
+{
+    return (sopt && std::strcmp(arg, sopt) == 0) || std::strcmp(arg, lopt) == 0;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Parse exactly `count` comma separated numbers.
+*/
+bool ParseNumbers(const char * str, double * values, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        char * end = nullptr;
+        // Attempt to convert the next value
+        values[i] = std::strtod(str, &end);
+        // Was there a value? Is it followed by the right separator?
+        if (end == str || *end != (i + 1 < count ? ',' : '\0'))
+        {
+            return false;
+        }
+        // Move past the separator
+        str = end + 1;
+    }
+    // All values were parsed
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Parse a comma separated list of model identifiers.
+*/
+bool ParseModels(const char * str, std::vector< int > & models)
+{
+    for (;;)
+    {
+        char * end = nullptr;
+        // Attempt to convert the next value
+        const long id = std::strtol(str, &end, 10);
+        // Was there a value?
+        if (end == str || (*end != ',' && *end != '\0'))
+        {
+            return false;
+        }
+        models.push_back(static_cast< int >(id));
+        // Was this the last one?
+        if (*end == '\0')
+        {
+            return true;
+        }
+        // Move past the separator
+        str = end + 1;
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Parse the command line into the specified options.
+*/
+bool ParseOptions(int argc, char ** argv, Options & opts)
+{
+    // Whether anything about the main output was specified
+    bool main = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char * arg = argv[i];
+        // Retrieve the value of the current option
+        auto value = [&]() -> const char * {
+            if (i + 1 >= argc)
+            {
+                std::fprintf(stderr, "Missing value for option: %s\n", arg);
+                // Let the caller know
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        // The value of the current option, if any
+        const char * val = nullptr;
+        // Identify the option
+        if (Is(arg, "-f", "--format"))
+        {
+            if (!(val = value()) || !FormatFromName(val, opts.mFormat))
+            {
+                if (val)
+                {
+                    std::fprintf(stderr, "Unknown output format: %s\n", val);
+                }
+                // We're done here
+                return false;
+            }
+            main = true;
+        }
+        else if (Is(arg, nullptr, "--func"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mFunc = val;
+        }
+        else if (Is(arg, "-t", "--template"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mTemplate = val, main = true;
+        }
+        else if (Is(arg, "-o", "--output"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mOutput = val, main = true;
+        }
+        else if (Is(arg, "-e", "--emit"))
+        {
+            const char * sep = nullptr;
+            Target target;
+            // Expect the name of a format and the file it goes to
+            if (!(val = value()) || !(sep = std::strchr(val, '=')) || sep[1] == '\0' ||
+                !FormatFromName(std::string(val, sep).c_str(), target.mFormat))
+            {
+                std::fprintf(stderr, "Invalid output, expected: format=path\n");
+                // We're done here
+                return false;
+            }
+            target.mPath = sep + 1;
+            opts.mTargets.push_back(std::move(target));
+        }
+        else if (Is(arg, "-j", "--jobs"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mJobs = static_cast< unsigned >(std::strtoul(val, nullptr, 10));
+        }
+        else if (Is(arg, nullptr, "--diagnostics"))
+        {
+            opts.mDiagnostics = true;
+        }
+        else if (Is(arg, nullptr, "--cache"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mCache = val;
+        }
+        else if (Is(arg, "-w", "--watch"))
+        {
+            opts.mWatch = true;
+        }
+        else if (Is(arg, nullptr, "--stream"))
+        {
+            opts.mStream = true;
+        }
+        else if (Is(arg, nullptr, "--grid-size"))
+        {
+            if (!(val = value()) || !ParseNumbers(val, &opts.mGridSize, 1) ||
+                !(opts.mGridSize > 0.0))
+            {
+                std::fprintf(stderr, "Invalid grid size\n");
+                // We're done here
+                return false;
+            }
+        }
+        else if (Is(arg, nullptr, "--diff"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mBase.emplace_back(val);
+        }
+        else if (Is(arg, nullptr, "--removed"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mRemoved = val;
+        }
+        else if (Is(arg, nullptr, "--show-func"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mShowFunc = val;
+        }
+        else if (Is(arg, nullptr, "--index"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mIndexIn = val;
+        }
+        else if (Is(arg, nullptr, "--save-index"))
+        {
+            if (!(val = value()))
+            {
+                return false;
+            }
+            opts.mIndexOut = val;
+        }
+        else if (Is(arg, nullptr, "--cell-size"))
+        {
+            if (!(val = value()) || !ParseNumbers(val, &opts.mCellSize, 1) ||
+                !(opts.mCellSize > 0.0))
+            {
+                std::fprintf(stderr, "Invalid cell size\n");
+                // We're done here
+                return false;
+            }
+        }
+        else if (Is(arg, nullptr, "--box"))
+        {
+            double v[6];
+            // Expect both corners
+            if (!(val = value()) || !ParseNumbers(val, v, 6))
+            {
+                std::fprintf(stderr, "Invalid box, expected: minx,miny,minz,maxx,maxy,maxz\n");
+                // We're done here
+                return false;
+            }
+            opts.mQuery.mBox = true;
+            // Accept the corners in any order
+            for (int k = 0; k < 3; ++k)
+            {
+                opts.mQuery.mMin[k] = std::min(v[k], v[k + 3]);
+                opts.mQuery.mMax[k] = std::max(v[k], v[k + 3]);
+            }
+            // Boxes don't need the index
+            opts.mFilter.mBox = true;
+            std::copy(opts.mQuery.mMin, opts.mQuery.mMin + 3, opts.mFilter.mMin);
+            std::copy(opts.mQuery.mMax, opts.mQuery.mMax + 3, opts.mFilter.mMax);
+        }
+        else if (Is(arg, nullptr, "--near"))
+        {
+            double v[4];
+            // Expect the point and the distance
+            if (!(val = value()) || !ParseNumbers(val, v, 4) || !(v[3] >= 0.0))
+            {
+                std::fprintf(stderr, "Invalid point, expected: x,y,z,radius\n");
+                // We're done here
+                return false;
+            }
+            opts.mQuery.mSphere = true;
+            std::copy(v, v + 3, opts.mQuery.mCenter);
+            opts.mQuery.mRadius = v[3];
+        }
+        else if (Is(arg, nullptr, "--model"))
+        {
+            if (!(val = value()) || !ParseModels(val, opts.mQuery.mModels))
+            {
+                std::fprintf(stderr, "Invalid model list\n");
+                // We're done here
+                return false;
+            }
+            // Models don't need the index
+            opts.mFilter.mAllow = opts.mQuery.mModels;
+        }
+        else if (Is(arg, nullptr, "--deny"))
+        {
+            if (!(val = value()) || !ParseModels(val, opts.mFilter.mDeny))
+            {
+                std::fprintf(stderr, "Invalid model list\n");
+                // We're done here
+                return false;
+            }
+        }
+        else if (Is(arg, nullptr, "--z-range"))
+        {
+            double v[2];
+            // Expect both heights
+            if (!(val = value()) || !ParseNumbers(val, v, 2))
+            {
+                std::fprintf(stderr, "Invalid height range, expected: min,max\n");
+                // We're done here
+                return false;
+            }
+            opts.mFilter.mRange = true;
+            opts.mFilter.mLow = std::min(v[0], v[1]), opts.mFilter.mHigh = std::max(v[0], v[1]);
+        }
+        else if (Is(arg, "-h", "--help"))
+        {
+            return false;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            std::fprintf(stderr, "Unknown option: %s\n", arg);
+            // We're done here
+            return false;
+        }
+        else
+        {
+            opts.mInputs.emplace_back(arg);
+        }
+    }
+    // The main output is generated unless only other outputs were requested
+    if (opts.mTargets.empty() || main)
+    {
+        opts.mTargets.insert(opts.mTargets.begin(), Target{opts.mFormat, opts.mTemplate,
+                                                            opts.mOutput});
+    }
+    // Templates generate text
+    if (!opts.mTemplate.empty() && (IsBinary(opts.mFormat) || IsTable(opts.mFormat)))
+    {
+        std::fprintf(stderr, "A template cannot be combined with binary output or tables\n");
+        // We're done here
+        return false;
+    }
+    // A saved index replaces the inputs
+    else if (!opts.mIndexIn.empty() && !opts.mInputs.empty())
+    {
+        std::fprintf(stderr, "Input files cannot be combined with a saved index\n");
+        // We're done here
+        return false;
+    }
+    // Do we have anything to process?
+    else if (opts.mInputs.empty() && opts.mIndexIn.empty())
+    {
+        std::fprintf(stderr, "No input files or directories specified\n");
+        // We're done here
+        return false;
+    }
+    // Watching needs files to watch and a file to update
+    else if (opts.mWatch && (opts.mInputs.empty() || opts.mTargets.front().mPath.empty()))
+    {
+        std::fprintf(stderr, "Watching requires input files and an output file\n");
+        // We're done here
+        return false;
+    }
+    // Comparisons work on the instances of the files
+    else if (!opts.mBase.empty() && (opts.Indexed() || opts.mWatch))
+    {
+        std::fprintf(stderr, "A comparison cannot be combined with an index or with watching\n");
+        // We're done here
+        return false;
+    }
+    // Streaming only works when each instance is generated on its own
+    else if (opts.mStream && (opts.Joined() || opts.mTargets.size() > 1 || opts.mWatch ||
+                                IsTable(opts.mTargets.front().mFormat) || !opts.mCache.empty()))
+    {
+        std::fprintf(stderr, "Streaming requires a single text output without an index, "
+                                "a comparison, watching or a cache\n");
+        // We're done here
+        return false;
+    }
+    // Removed instances only come from comparisons
+    else if (!opts.mRemoved.empty() && opts.mBase.empty())
+    {
+        std::fprintf(stderr, "Removed instances require a previous version to compare with\n");
+        // We're done here
+        return false;
+    }
+    // There is no single format to write the removed instances in
+    else if (!opts.mRemoved.empty() && opts.mTargets.size() > 1)
+    {
+        std::fprintf(stderr, "Removed instances cannot be combined with several outputs\n");
+        // We're done here
+        return false;
+    }
+    // Every output needs a file of its own
+    for (size_t i = 0; i < opts.mTargets.size(); ++i)
+    {
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (opts.mTargets[i].mPath == opts.mTargets[j].mPath)
+            {
+                std::fprintf(stderr, "Several outputs go to the same file: %s\n",
+                                opts.mTargets[i].mPath.c_str());
+                // We're done here
+                return false;
+            }
+        }
+    }
+    // Options are valid
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * See whether the specified path has the IPL extension. (case insensitive)
+*/
+bool IsIPL(const fs::path & path)
+{
+    const std::string ext = path.extension().string();
+    // Compare the extension without caring about the case
+    return ext.size() == 4 && ext[0] == '.' &&
+            std::tolower(static_cast< unsigned char >(ext[1])) == 'i' &&
+            std::tolower(static_cast< unsigned char >(ext[2])) == 'p' &&
+            std::tolower(static_cast< unsigned char >(ext[3])) == 'l';
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Expand the inputs into a list of files. Files found in directories are sorted so the output
+ * does not depend on the order in which the file system enumerates them.
+*/
+bool CollectFiles(const std::vector< std::string > & inputs, std::vector< std::string > & files)
+{
+    for (const auto & input : inputs)
+    {
+        std::error_code ec;
+        // Is this a directory that must be searched?
+        if (fs::is_directory(input, ec))
+        {
+            std::vector< std::string > found;
+            // Look for IPL files in this directory and every sub-directory
+            for (fs::recursive_directory_iterator itr(input, ec), end; !ec && itr != end;
+                                                                            itr.increment(ec))
+            {
+                if (itr->is_regular_file(ec) && IsIPL(itr->path()))
+                {
+                    found.push_back(itr->path().string());
+                }
+            }
+            // Did the search fail?
+            if (ec)
+            {
+                std::fprintf(stderr, "Unable to search directory: %s (%s)\n",
+                                input.c_str(), ec.message().c_str());
+                // We're done here
+                return false;
+            }
+            // Keep the order deterministic
+            std::sort(found.begin(), found.end());
+            // Add them to the list
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        // Explicitly specified files are taken as is
+        else
+        {
+            files.push_back(input);
+        }
+    }
+    // Files were collected
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Prepare what generates the output of the specified target, using the specified function name in
+ * scripts. Text output goes through a template, which is compiled into the specified one.
+*/
+bool MakeGenerator(const Options & opts, const Target & target, const std::string & func,
+                    Template & tpl, Generator & generate)
+{
+    const Format fmt = target.mFormat;
+    // Grids are generated directly with the requested cell size
+    if (IsGrid(fmt))
+    {
+        generate = [fmt, &func, size = opts.mGridSize](const Instances & inst_list, Writer & out) {
+            return BuildGrid(fmt, inst_list, func.c_str(), size, out);
+        };
+        // We're done here
+        return true;
+    }
+    // Binary output and script tables are generated directly
+    else if (IsBinary(fmt) || IsTable(fmt))
+    {
+        generate = [fmt, &func](const Instances & inst_list, Writer & out) {
+            return Build(fmt, inst_list, func.c_str(), out);
+        };
+        // We're done here
+        return true;
+    }
+    const char * pattern = target.mTemplate.c_str();
+    std::string error;
+    // Compile the template that generates text output
+    if (!(target.mTemplate.empty() ? tpl.Compile(FormatTemplate(fmt), func.c_str(), error)
+                                   : tpl.CompileLine(pattern, func.c_str(), error)))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        // We're done here
+        return false;
+    }
+    generate = [&tpl](const Instances & inst_list, Writer & out) {
+        return tpl.Emit(inst_list, out);
+    };
+    // The template is ready
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the form of a path used to recognize the same file when it's reported by the watcher.
+*/
+std::string PathKey(const std::string & path)
+{
+    return fs::path(path).lexically_normal().string();
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Join the instances of every task in the order of the inputs. The memory of each task is only
+ * released if the instances are not needed again.
+*/
+void JoinInstances(std::vector< Task > & tasks, Instances & inst_list, bool keep)
+{
+    size_t count = 0;
+    // Allocate the whole list at once
+    for (const auto & task : tasks)
+    {
+        count += task.mInstances.size();
+    }
+    inst_list.reserve(inst_list.size() + count);
+    // Copy the instances over
+    for (auto & task : tasks)
+    {
+        inst_list.insert(inst_list.end(), task.mInstances.begin(), task.mInstances.end());
+        // Release the memory of the task, if allowed
+        if (!keep)
+        {
+            Instances().swap(task.mInstances);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract and filter the instances of a single file and generate the output of every target,
+ * unless the output needs the instances of every file at once. The contents are parsed straight
+ * from the file that was already read, if any. Otherwise the file is mapped, and only goes
+ * through the cache if there is one.
+*/
+void ProcessTask(const Options & opts, InstanceCache * cache, const LoadedFile * file,
+                    const std::vector< Generator > & generate, Task & task)
+{
+    // Problems are kept with the task so they can be displayed in order
+    Diagnostics & diag = task.mDiagnostics;
+    const Reporter report = diag.Bind(diag.AddFile(task.mPath));
+    // Whether any instances were extracted from the file
+    bool extracted = false;
+    // Was the file already read?
+    if (file)
+    {
+        diag.Times().Add(Stage::Read, file->mSeconds);
+        // See if the file could be read
+        if (!file->mOpen)
+        {
+            report(Category::File, "Unable to open the selected file", 0);
+        }
+        else
+        {
+            extracted = ExtractBuffer(file->mData.get(), file->mSize, task.mInstances, report,
+                                        Progress(), &diag.Times());
+        }
+    }
+    // Populate the list with elements from the file
+    else
+    {
+        extracted = cache
+            ? cache->Extract(task.mPath.c_str(), task.mInstances, report, Progress(), &diag.Times())
+            : Extract(task.mPath.c_str(), task.mInstances, report, Progress(), &diag.Times());
+    }
+    // Problems with the whole file mean it could not be processed
+    task.mFailed = (diag.Count(Category::File) > 0);
+    // The index must see every instance, so it is filtered afterwards
+    if (!opts.Indexed())
+    {
+        Stopwatch watch;
+        Apply(opts.mFilter, task.mInstances);
+        // Filtering counts as conversion
+        diag.Times().Add(Stage::Convert, watch.Lap());
+    }
+    // Is there anything to generate for this file alone?
+    if (!extracted)
+    {
+        return; // Nothing to generate
+    }
+    Stopwatch watch;
+    task.mOutputs.resize(generate.size());
+    // Generate the targets that only need this file, all from the same instances
+    for (size_t t = 0; t < generate.size(); ++t)
+    {
+        if (!opts.Joined(opts.mTargets[t]))
+        {
+            task.mFailed |= !generate[t](task.mInstances, task.mOutputs[t]);
+        }
+    }
+    diag.Times().Add(Stage::Format, watch.Lap());
+    // Are the instances still needed?
+    if (!opts.Joined())
+    {
+        Instances().swap(task.mInstances);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate the output of every target that needs the instances of every file at once, if any.
+ * The targets are generated in parallel from the same list. The instances are left with the tasks
+ * when requested, so the output can be generated again later. Returns false if nothing should be
+ * written, and records whether the output is incomplete otherwise.
+*/
+bool GenerateJoined(const Options & opts, const std::vector< Generator > & generate,
+                    std::vector< Task > & tasks, Diagnostics & diag,
+                    std::vector< Writer > & joined, bool keep, bool & failed)
+{
+    joined.resize(generate.size());
+    // Do the instances of every file have to be processed together?
+    if (!opts.Joined())
+    {
+        return true; // Each file already generated its own output
+    }
+    // The instances to generate
+    Instances inst_list;
+    // Do the instances go through the spatial index?
+    if (opts.Indexed())
+    {
+        SpatialIndex index;
+        // Load the saved index, if any
+        if (!opts.mIndexIn.empty() && !index.Load(opts.mIndexIn.c_str()))
+        {
+            std::fprintf(stderr, "Unable to load the index: %s\n", opts.mIndexIn.c_str());
+            // We're done here
+            return false;
+        }
+        // Otherwise index the parsed files
+        else if (opts.mIndexIn.empty())
+        {
+            JoinInstances(tasks, inst_list, keep);
+            index.Build(inst_list, opts.mCellSize);
+            inst_list.clear();
+        }
+        // Save the index, if requested
+        if (!opts.mIndexOut.empty() && !index.Save(opts.mIndexOut.c_str()))
+        {
+            std::fprintf(stderr, "Unable to save the index: %s\n", opts.mIndexOut.c_str());
+            // We're done here
+            return false;
+        }
+        // Saving an index is a job on its own, unless something was also queried
+        if (opts.IndexOnly())
+        {
+            return true;
+        }
+        // Find the instances that meet the conditions
+        index.Find(opts.mQuery, inst_list);
+        // Check the conditions that the index does not know about
+        Apply(opts.mFilter, inst_list);
+    }
+    else
+    {
+        JoinInstances(tasks, inst_list, keep);
+    }
+    Stopwatch watch;
+    std::vector< size_t > pending;
+    // Collect the targets that were not generated for each file
+    for (size_t t = 0; t < generate.size(); ++t)
+    {
+        if (opts.Joined(opts.mTargets[t]))
+        {
+            pending.push_back(t);
+        }
+    }
+    // Which targets failed, kept apart since they're generated on separate threads
+    std::vector< char > target_failed(generate.size(), 0);
+    // Generate the output of those targets
+    ParallelFor(pending.size(), opts.mJobs ? opts.mJobs : DefaultJobs(), [&](size_t i) {
+        target_failed[pending[i]] = !generate[pending[i]](inst_list, joined[pending[i]]);
+    });
+    failed |= std::find(target_failed.begin(), target_failed.end(), 1) != target_failed.end();
+    diag.Times().Add(Stage::Format, watch.Lap());
+    // Whatever was generated can be written
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate the output of every target for the instances that were added since the previous
+ * version of the inputs and, if requested, the output of those that were removed.
+*/
+void GenerateDiff(const Options & opts, const std::vector< Generator > & generate,
+                    const Generator & undo, std::vector< Task > & tasks, std::vector< Task > & base,
+                    Diagnostics & diag, std::vector< Writer > & added_out, Writer & removed_out,
+                    bool & failed)
+{
+    Instances before, after, added, removed;
+    // Bring together each version of the inputs
+    JoinInstances(base, before, false);
+    JoinInstances(tasks, after, false);
+    Stopwatch watch;
+    // Find what changed
+    Compare(before, after, added, removed);
+    // Comparing counts as conversion
+    diag.Times().Add(Stage::Convert, watch.Lap());
+    // Generate the output of each side
+    added_out.resize(generate.size());
+    for (size_t t = 0; t < generate.size(); ++t)
+    {
+        failed |= !generate[t](added, added_out[t]);
+    }
+    if (!opts.mRemoved.empty())
+    {
+        failed |= !undo(removed, removed_out);
+    }
+    diag.Times().Add(Stage::Format, watch.Lap());
+    // Let the user know how big the change is, unless a report was requested
+    if (!opts.mDiagnostics)
+    {
+        std::fprintf(stderr, "Compared %zu with %zu instances: %zu added, %zu removed\n",
+                        before.size(), after.size(), added.size(), removed.size());
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Write the output of the specified target from every task, followed by the joined output, to the
+ * specified file or to the standard output when empty. When replacing, the output is written next
+ * to the file and then renamed over it, so that readers only ever see a complete output.
+*/
+bool WriteOutput(const std::string & output, const std::vector< Task > & tasks, size_t target,
+                    const Writer & joined, bool replace)
+{
+    // Where the output is written first
+    const std::string path = replace ? output + ".tmp" : output;
+    // Open the output file, if any
+    std::FILE * out = stdout;
+    if (!path.empty() && (out = std::fopen(path.c_str(), "wb")) == nullptr)
+    {
+        std::fprintf(stderr, "Unable to open the output file: %s\n", path.c_str());
+        // We're done here
+        return false;
+    }
+    bool ok = true;
+    // Write the results in the order of the inputs
+    for (const auto & task : tasks)
+    {
+        // Files that produced nothing have no output
+        if (target < task.mOutputs.size())
+        {
+            ok &= task.mOutputs[target].WriteTo(out);
+        }
+    }
+    ok &= joined.WriteTo(out);
+    // Make sure everything reached the file
+    if (std::fflush(out) != 0 || std::ferror(out))
+    {
+        std::fprintf(stderr, "Unable to write the output\n");
+        ok = false;
+    }
+    // Close the file if we opened one
+    if (out != stdout)
+    {
+        ok &= (std::fclose(out) == 0);
+    }
+    // Is there anything to replace?
+    if (!replace)
+    {
+        return ok;
+    }
+    std::error_code ec;
+    // Replace the previous output in one go
+    if (ok)
+    {
+        fs::rename(path, output, ec);
+    }
+    // Don't leave anything behind on failure
+    if (!ok || ec)
+    {
+        std::fprintf(stderr, "Unable to replace the output file: %s\n", output.c_str());
+        fs::remove(path, ec);
+        return false;
+    }
+    // The output was replaced
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Pass the instances of every file through the filter and the generator in batches and write
+ * the output as it's generated. Parsing, generating and writing happen on separate threads that
+ * hand batches to each other through bounded queues, so memory stays the same however large the
+ * inputs are.
+*/
+bool StreamFiles(const Options & opts, const Generator & generate,
+                    const std::vector< std::string > & files, Diagnostics & diag)
+{
+    // Streaming has a single output
+    const std::string & path = opts.mTargets.front().mPath;
+    // Open the output file, if any
+    std::FILE * out = stdout;
+    if (!path.empty() && (out = std::fopen(path.c_str(), "wb")) == nullptr)
+    {
+        std::fprintf(stderr, "Unable to open the output file: %s\n", path.c_str());
+        // We're done here
+        return false;
+    }
+    // Batches of instances waiting to be generated and output waiting to be written
+    Queue< Instances > parsed(StreamDepth);
+    Queue< Writer > generated(StreamDepth);
+    // Time spent generating, kept apart since it's measured on another thread
+    Timings gen_times;
+    bool gen_failed = false;
+    // Extract the files in order
+    std::thread parser([&]() {
+        // Whether nobody takes the batches anymore
+        bool stopped = false;
+        for (size_t i = 0; i < files.size() && !stopped; ++i)
+        {
+            const Reporter report = diag.Bind(diag.AddFile(files[i]));
+            // Hand over the instances in batches
+            ExtractStream(files[i].c_str(), StreamBatch, [&](Instances & batch) {
+                Instances next;
+                next.reserve(StreamBatch);
+                // Leave an empty list with room for the next batch
+                batch.swap(next);
+                stopped = !parsed.Push(std::move(next));
+                return !stopped;
+            }, report, Progress(), &diag.Times());
+        }
+        parsed.Close();
+    });
+    // Filter the batches and generate their output
+    std::thread generator([&]() {
+        Instances batch;
+        while (parsed.Pop(batch))
+        {
+            Stopwatch watch;
+            Apply(opts.mFilter, batch);
+            // Filtering counts as conversion
+            gen_times.Add(Stage::Convert, watch.Lap());
+            Writer output;
+            gen_failed |= !generate(batch, output);
+            gen_times.Add(Stage::Format, watch.Lap());
+            // Stop if nobody writes the output anymore
+            if (!generated.Push(std::move(output)))
+            {
+                parsed.Cancel();
+            }
+        }
+        generated.Close();
+    });
+    bool ok = true;
+    // Write the output on this thread as it arrives
+    for (Writer output; generated.Pop(output); )
+    {
+        Stopwatch watch;
+        // Stop everything once writing fails
+        if (!output.WriteTo(out) || std::ferror(out))
+        {
+            generated.Cancel();
+            ok = false;
+        }
+        diag.Times().Add(Stage::Display, watch.Lap());
+    }
+    parser.join();
+    generator.join();
+    diag.Times().Merge(gen_times);
+    // Make sure everything reached the file
+    if (!ok || std::fflush(out) != 0 || std::ferror(out))
+    {
+        std::fprintf(stderr, "Unable to write the output\n");
+        ok = false;
+    }
+    // Close the file if we opened one
+    if (out != stdout)
+    {
+        ok &= (std::fclose(out) == 0);
+    }
+    // Report whether every file was processed and written
+    return ok && !gen_failed && diag.Count(Category::File) == 0;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Find the tasks affected by the specified changes. Tasks are created and dropped as files come
+ * and go, and those that must be processed again are marked as stale.
+*/
+bool UpdateTasks(const Options & opts, const std::vector< Watcher::Change > & changes,
+                    std::vector< Task > & tasks, std::vector< bool > & stale, bool & moved)
+{
+    moved = false;
+    // Tasks by the path of their file
+    std::unordered_map< std::string, size_t > known;
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        known.emplace(PathKey(tasks[i].mPath), i);
+    }
+    stale.assign(tasks.size(), false);
+    // Whether files may have come or gone
+    bool collect = false;
+    // See what each change affects
+    for (const auto & change : changes)
+    {
+        const std::string key = PathKey(change.mPath);
+        std::error_code ec;
+        // Anything in a directory that came, went or was missed may have changed
+        if (change.mDirectory)
+        {
+            const std::string prefix = (fs::path(key) / "").string();
+            // Process the files in it again
+            for (const auto & k : known)
+            {
+                if (k.first.compare(0, prefix.size(), prefix) == 0)
+                {
+                    stale[k.second] = true;
+                }
+            }
+            collect = true;
+        }
+        // Is this one of the processed files?
+        else if (auto itr = known.find(key); itr != known.end())
+        {
+            stale[itr->second] = true;
+            // Files that went away are no longer found in directories
+            collect |= !fs::is_regular_file(change.mPath, ec);
+        }
+        // New files are only of interest if they would have been found
+        else
+        {
+            collect |= IsIPL(change.mPath);
+        }
+    }
+    // Is the list of files still the same?
+    if (!collect)
+    {
+        return true;
+    }
+    std::vector< std::string > files;
+    // Look for the files again
+    if (!CollectFiles(opts.mInputs, files))
+    {
+        return false;
+    }
+    std::vector< Task > next(files.size());
+    std::vector< bool > next_stale(files.size(), true);
+    // Keep the tasks of files that are still there and did not change
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        auto itr = known.find(PathKey(files[i]));
+        // Was this file processed already?
+        if (itr != known.end() && !stale[itr->second] && !tasks[itr->second].mPath.empty())
+        {
+            next[i] = std::move(tasks[itr->second]);
+            next_stale[i] = false;
+            // The task cannot be taken twice
+            tasks[itr->second].mPath.clear();
+        }
+        else
+        {
+            next[i].mPath = std::move(files[i]);
+        }
+    }
+    // Files that went away still change the output
+    moved = next.size() != tasks.size() || std::any_of(tasks.begin(), tasks.end(),
+                                                [](const Task & t) { return !t.mPath.empty(); });
+    // Use the new list of files
+    tasks.swap(next);
+    stale.swap(next_stale);
+    // The tasks were updated
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Regenerate the output whenever the inputs change. Only the files that changed are parsed again
+ * and only their part of the output is generated again, unless the output needs every instance.
+*/
+int WatchInputs(const Options & opts, const std::vector< Generator > & generate,
+                std::vector< Task > & tasks)
+{
+    Watcher watcher;
+    std::string error;
+    // Watch every input
+    for (const auto & input : opts.mInputs)
+    {
+        if (!watcher.Add(input, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            // We're done here
+            return EXIT_FAILURE;
+        }
+    }
+    std::fprintf(stderr, "Watching for changes...\n");
+    // Changes reported by the watcher
+    std::vector< Watcher::Change > changes;
+    // Tasks that must be processed again
+    std::vector< bool > stale;
+    // Whether files came or went
+    bool moved = false;
+    // Keep going until the watcher fails
+    while (watcher.Wait(changes, error))
+    {
+        Stopwatch elapsed;
+        // Find out what must be processed again
+        if (!UpdateTasks(opts, changes, tasks, stale, moved))
+        {
+            continue; // Wait for the inputs to be fixed
+        }
+        std::vector< size_t > pending;
+        // Collect the tasks that are stale
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            if (stale[i])
+            {
+                pending.push_back(i);
+            }
+        }
+        // Did anything that ends up in the output change?
+        if (pending.empty() && !moved)
+        {
+            continue;
+        }
+        // Process the files again without the cache, since they are known to have changed
+        ParallelFor(pending.size(), opts.mJobs ? opts.mJobs : DefaultJobs(), [&](size_t i) {
+            Task & task = tasks[pending[i]];
+            // Start over
+            task.mInstances.clear();
+            task.mOutputs.clear();
+            task.mDiagnostics.Clear();
+            ProcessTask(opts, nullptr, nullptr, generate, task);
+        });
+        // Whether any file failed
+        bool failed = false;
+        for (const auto & task : tasks)
+        {
+            failed |= task.mFailed;
+        }
+        // Only the problems of the files that were processed again are new
+        Diagnostics diag;
+        for (const size_t i : pending)
+        {
+            diag.Merge(tasks[i].mDiagnostics);
+        }
+        // Generate and replace the output of every target
+        std::vector< Writer > joined;
+        if (!GenerateJoined(opts, generate, tasks, diag, joined, true, failed))
+        {
+            failed = true;
+        }
+        else if (!opts.IndexOnly())
+        {
+            Stopwatch watch;
+            for (size_t t = 0; t < opts.mTargets.size(); ++t)
+            {
+                failed |= !WriteOutput(opts.mTargets[t].mPath, tasks, t, joined[t], true);
+            }
+            diag.Times().Add(Stage::Display, watch.Lap());
+        }
+        diag.Times().mElapsed = elapsed.Lap();
+        // Display the problems and what was done
+        std::fputs(opts.mDiagnostics ? diag.JSON().c_str() : diag.Log().c_str(), stderr);
+        std::fprintf(stderr, "%s %s%s (%zu of %zu files processed again) in %.3f s\n",
+                        failed ? "Failed to update" : "Updated",
+                        opts.mTargets.front().mPath.c_str(),
+                        opts.mTargets.size() > 1 ? " and the other outputs" : "",
+                        pending.size(), tasks.size(), diag.Times().mElapsed);
+    }
+    std::fprintf(stderr, "%s\n", error.c_str());
+    // Watching failed
+    return EXIT_FAILURE;
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+bool IsBatch(int argc, char ** argv)
+{
+    // Only look at the first argument to leave the standard window options alone
+    if (argc < 2)
+    {
+        return false;
+    }
+    const char * arg = argv[1];
+    // Long options, our short options and plain paths select the batch mode
+    return (arg[0] != '-' || arg[1] == '-' || std::strcmp(arg, "-o") == 0 ||
+            std::strcmp(arg, "-f") == 0 || std::strcmp(arg, "-j") == 0 ||
+            std::strcmp(arg, "-t") == 0 || std::strcmp(arg, "-w") == 0 ||
+            std::strcmp(arg, "-e") == 0 || std::strcmp(arg, "-h") == 0);
+}
+
+// ------------------------------------------------------------------------------------------------
+int RunBatch(int argc, char ** argv)
+{
+    // Measures the whole run
+    Stopwatch elapsed;
+    Options opts;
+    // Attempt to parse the command line
+    if (!ParseOptions(argc, argv, opts))
+    {
+        Usage(argv[0]);
+        // We're done here
+        return EXIT_FAILURE;
+    }
+    // Templates that generate text output, if used (never resized, generators refer to them)
+    std::vector< Template > tpl(opts.mTargets.size());
+    Template undo_tpl;
+    // Generate the output of every target from the specified instances, and of the removed ones
+    std::vector< Generator > generate(opts.mTargets.size());
+    Generator undo;
+    for (size_t t = 0; t < opts.mTargets.size(); ++t)
+    {
+        if (!MakeGenerator(opts, opts.mTargets[t], opts.mFunc, tpl[t], generate[t]))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    if (!opts.mRemoved.empty() &&
+        !MakeGenerator(opts, opts.mTargets.front(), opts.mShowFunc, undo_tpl, undo))
+    {
+        return EXIT_FAILURE;
+    }
+    // Expand the inputs, and the previous version of them, into individual files
+    std::vector< std::string > files, base_files;
+    if (!CollectFiles(opts.mInputs, files) || !CollectFiles(opts.mBase, base_files))
+    {
+        return EXIT_FAILURE;
+    }
+    // Are the instances passed through without ever being kept?
+    if (opts.mStream)
+    {
+        Diagnostics diag;
+        const bool streamed = StreamFiles(opts, generate.front(), files, diag);
+        // Display the problems as they are, or report the diagnostics
+        if (opts.mDiagnostics)
+        {
+            diag.Times().mElapsed = elapsed.Lap();
+            std::fputs(diag.JSON().c_str(), stderr);
+        }
+        else
+        {
+            std::fputs(diag.Log().c_str(), stderr);
+        }
+        return streamed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    // Files only go through the cache once per run, so nothing is kept in memory
+    InstanceCache cache(opts.mCache, false);
+    // Create a task for each file
+    std::vector< Task > tasks(files.size()), base(base_files.size());
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        tasks[i].mPath = std::move(files[i]);
+    }
+    for (size_t i = 0; i < base_files.size(); ++i)
+    {
+        base[i].mPath = std::move(base_files[i]);
+    }
+    const unsigned jobs = opts.mJobs ? opts.mJobs : DefaultJobs();
+    // Retrieve the task of the specified file from either version
+    auto task_of = [&](size_t i) -> Task & {
+        return i < tasks.size() ? tasks[i] : base[i - tasks.size()];
+    };
+    // Are the files read in bulk? Only worth it when there is no cache that could skip them
+    if (opts.mCache.empty() && tasks.size() + base.size() > 1)
+    {
+        std::vector< std::string > paths;
+        paths.reserve(tasks.size() + base.size());
+        for (size_t i = 0; i < tasks.size() + base.size(); ++i)
+        {
+            paths.push_back(task_of(i).mPath);
+        }
+        // Parse the files of both versions as soon as they were read
+        ReadFiles(paths, jobs, [&](LoadedFile & file) {
+            ProcessTask(opts, nullptr, &file, generate, task_of(file.mIndex));
+        });
+    }
+    else
+    {
+        // Process the files of both versions across the worker pool
+        ParallelFor(tasks.size() + base.size(), jobs, [&](size_t i) {
+            ProcessTask(opts, &cache, nullptr, generate, task_of(i));
+        });
+    }
+    // Whether any file failed
+    bool failed = false;
+    // Gather the problems and timings in the order of the inputs
+    Diagnostics diag;
+    for (const auto * list : {&tasks, &base})
+    {
+        for (const auto & task : *list)
+        {
+            diag.Merge(task.mDiagnostics);
+            failed |= task.mFailed;
+        }
+    }
+    // Display the problems as they are, unless a report was requested
+    if (!opts.mDiagnostics)
+    {
+        std::fputs(diag.Log().c_str(), stderr);
+    }
+    // Leave with the specified code and report the diagnostics, if requested
+    auto finish = [&](int code) {
+        if (opts.mDiagnostics)
+        {
+            diag.Times().mElapsed = elapsed.Lap();
+            std::fputs(diag.JSON().c_str(), stderr);
+        }
+        // Keep going when watching, regardless of how the first pass went
+        return opts.mWatch ? WatchInputs(opts, generate, tasks) : code;
+    };
+    // Output of every target generated from the instances of every file at once
+    std::vector< Writer > joined;
+    // Output of the removed instances
+    Writer removed;
+    // Is this a comparison?
+    if (!opts.mBase.empty())
+    {
+        GenerateDiff(opts, generate, undo, tasks, base, diag, joined, removed, failed);
+    }
+    // The instances are needed again when watching
+    else if (!GenerateJoined(opts, generate, tasks, diag, joined, opts.mWatch, failed))
+    {
+        return finish(EXIT_FAILURE);
+    }
+    // Saving an index is a job on its own, unless something was also queried
+    else if (opts.IndexOnly())
+    {
+        return finish(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+    // Measure how long it takes to hand over the output
+    Stopwatch watch;
+    // Write the results of every target in the order of the inputs
+    for (size_t t = 0; t < opts.mTargets.size(); ++t)
+    {
+        failed |= !WriteOutput(opts.mTargets[t].mPath, tasks, t, joined[t], opts.mWatch);
+    }
+    // Write the removed instances separately, if requested
+    if (!opts.mRemoved.empty())
+    {
+        failed |= !WriteOutput(opts.mRemoved, std::vector< Task >(), 0, removed, false);
+    }
+    diag.Times().Add(Stage::Display, watch.Lap());
+    // Report whether everything went fine
+    return finish(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+} // Namespace:: VcMp
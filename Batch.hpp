@@ -0,0 +1,16 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * See whether the command line requests the headless batch mode instead of the window.
+*/
+bool IsBatch(int argc, char ** argv);
+
+/* ------------------------------------------------------------------------------------------------
+ * Process the files and directories from the command line without a window.
+*/
+int RunBatch(int argc, char ** argv);
+
+} // Namespace:: VcMp
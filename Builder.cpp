@@ -0,0 +1,463 @@
+// ------------------------------------------------------------------------------------------------
+#include "Builder.hpp"
+#include "HideList.hpp"
+#include "Template.hpp"
+#include "Quantize.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+
+// ------------------------------------------------------------------------------------------------
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+static const size_t ProgressStep = 4096; // Instances generated between progress updates
+static const size_t TableRowSize = 8; // Positions on each line of a script table
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * See whether the specified name matches the specified lowercase name, ignoring the case.
+*/
+bool IsName(const char * name, const char * lower)
+{
+    // Compare one character at a time until either of them ends
+    for (; *name != '\0' && *lower != '\0'; ++name, ++lower)
+    {
+        if (std::tolower(static_cast< unsigned char >(*name)) != *lower)
+        {
+            return false;
+        }
+    }
+    // Both must end at the same time
+    return (*name == *lower);
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+bool FormatFromName(const char * name, Format & fmt)
+{
+    if (IsName(name, "xml"))
+    {
+        fmt = Format::XML;
+    }
+    else if (IsName(name, "nut"))
+    {
+        fmt = Format::NUT;
+    }
+    else if (IsName(name, "raw"))
+    {
+        fmt = Format::RAW;
+    }
+    else if (IsName(name, "bin"))
+    {
+        fmt = Format::BIN;
+    }
+    else if (IsName(name, "tnut"))
+    {
+        fmt = Format::TNUT;
+    }
+    else if (IsName(name, "traw"))
+    {
+        fmt = Format::TRAW;
+    }
+    else if (IsName(name, "delta"))
+    {
+        fmt = Format::DELTA;
+    }
+    else if (IsName(name, "gnut"))
+    {
+        fmt = Format::GNUT;
+    }
+    else if (IsName(name, "graw"))
+    {
+        fmt = Format::GRAW;
+    }
+    else
+    {
+        return false; // Unknown format
+    }
+
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+const char * FormatTemplate(Format fmt)
+{
+    switch (fmt)
+    {
+        case Format::XML:
+            return "<rule model=\"{id}\">\n\t<position x=\"{x}\" y=\"{y}\" z=\"{z}\" />\n</rule>\n";
+        case Format::NUT: return "{func}({id}, {x}, {y}, {z});\n";
+        case Format::RAW: return "{func}({id}, {x:raw}, {y:raw}, {z:raw});\n";
+        case Format::BIN:
+        case Format::TNUT:
+        case Format::TRAW:
+        case Format::DELTA:
+        case Format::GNUT:
+        case Format::GRAW: return nullptr;
+    }
+    // Should not be reached
+    return nullptr;
+}
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate the specified text format through its template.
+*/
+bool BuildText(Format fmt, const Instances & inst_list, const char * func, Writer & out,
+                const Progress & progress)
+{
+    Template tpl;
+    std::string error;
+    // The built-in templates are known to compile
+    tpl.Compile(FormatTemplate(fmt), func, error);
+    // Generate the output
+    return tpl.Emit(inst_list, out, progress);
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * An instance and the map cell it belongs to.
+*/
+struct CellEntry
+{
+    // --------------------------------------------------------------------------------------------
+    int32_t     mX, mY; // Cell coordinates
+    uint32_t    mIndex; // Position of the instance in the list
+
+    /* --------------------------------------------------------------------------------------------
+     * Less than comparison operator. Orders by cell and then by position in the list.
+    */
+    bool operator < (const CellEntry & o) const
+    {
+        return mX != o.mX ? mX < o.mX : (mY != o.mY ? mY < o.mY : mIndex < o.mIndex);
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the cell that the specified coordinate falls in.
+*/
+inline int32_t CellOf(double v, double size)
+{
+    const double c = std::floor(v / size);
+    // Keep positions that are out of range, or not numbers, in the outermost cells
+    if (!(c >= -2147483648.0))
+    {
+        return INT32_MIN;
+    }
+    else if (c > 2147483647.0)
+    {
+        return INT32_MAX;
+    }
+    return static_cast< int32_t >(c);
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+bool BuildXML(const Instances & inst_list, Writer & out, const Progress & progress)
+{
+    return BuildText(Format::XML, inst_list, "", out, progress);
+}
+
+// ------------------------------------------------------------------------------------------------
+bool BuildNUT(const Instances & inst_list, const char * func, Writer & out,
+              const Progress & progress)
+{
+    return BuildText(Format::NUT, inst_list, func, out, progress);
+}
+
+// ------------------------------------------------------------------------------------------------
+bool BuildRAW(const Instances & inst_list, const char * func, Writer & out,
+              const Progress & progress)
+{
+    return BuildText(Format::RAW, inst_list, func, out, progress);
+}
+
+// ------------------------------------------------------------------------------------------------
+bool BuildTable(Format fmt, const Instances & inst_list, const char * func, Writer & out,
+                const Progress & progress)
+{
+    // Empty lists generate nothing, just like the other script formats
+    if (inst_list.empty())
+    {
+        return !out.Failed();
+    }
+    const size_t n = inst_list.size();
+    // Whether the adjusted coordinates are used and whether they are delta encoded
+    const bool raw = (fmt != Format::TNUT), delta = (fmt == Format::DELTA);
+    // The adjusted coordinates of each instance, if used
+    std::vector< int32_t > quant(raw ? n * 3 : 0);
+    if (raw)
+    {
+        QuantizePositions(inst_list.data(), n, quant.data());
+    }
+    // Group the instances by model
+    std::vector< uint32_t > order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    // Delta encoding works best when nearby positions follow each other
+    if (delta)
+    {
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return inst_list[a].mID != inst_list[b].mID ? inst_list[a].mID < inst_list[b].mID
+                    : std::lexicographical_compare(&quant[a * 3], &quant[a * 3 + 3],
+                                                    &quant[b * 3], &quant[b * 3 + 3]);
+        });
+    }
+    // Otherwise keep the original order of each model
+    else
+    {
+        std::vector< uint64_t > keys(n);
+        // Sort the model and the position together so the sort is stable and stays in cache
+        for (size_t i = 0; i < n; ++i)
+        {
+            keys[i] = static_cast< uint64_t >(static_cast< uint32_t >(inst_list[i].mID) ^
+                                                0x80000000u) << 32 | i;
+        }
+        std::sort(keys.begin(), keys.end());
+        // Keep only the positions
+        for (size_t i = 0; i < n; ++i)
+        {
+            order[i] = static_cast< uint32_t >(keys[i]);
+        }
+    }
+    // Keep the names local to this piece of output
+    out.Put("{\n\tlocal hide = {\n");
+    // Generate an array with the positions of each model
+    for (size_t i = 0; i < n; )
+    {
+        const int id = inst_list[order[i]].mID;
+        out.Put("\t\t[");
+        out.Put(id);
+        out.Put("] = [");
+        // Delta encoding starts over for each model
+        int32_t prev[3] = {0, 0, 0};
+        // Process every instance of this model
+        for (size_t k = 0; i < n && inst_list[order[i]].mID == id; ++i, ++k)
+        {
+            // Let the caller know how far we got and whether we should continue
+            if ((i % ProgressStep) == 0 && progress && !progress(i, n))
+            {
+                return false; // Cancelled!
+            }
+            // Keep the lines reasonably short
+            out.Put(k % TableRowSize == 0 ? "\n\t\t\t" : " ");
+            // Generate the position
+            for (unsigned a = 0; a < 3; ++a)
+            {
+                if (raw)
+                {
+                    const int32_t v = quant[order[i] * 3 + a];
+                    // Far apart positions of opposite sign don't fit a 32-bit difference
+                    out.PutLong(static_cast< int64_t >(v) - prev[a]);
+                    // Remember where the next delta starts from
+                    prev[a] = delta ? v : 0;
+                }
+                else
+                {
+                    const Instance & inst = inst_list[order[i]];
+                    out.Put(a == 0 ? inst.mX : (a == 1 ? inst.mY : inst.mZ));
+                }
+                out.Put(',');
+            }
+        }
+        out.Put("\n\t\t],\n");
+    }
+    // Generate the loop that invokes the function for every position
+    out.Put("\t};\n\tforeach (id, pos in hide)\n\t{\n");
+    if (delta)
+    {
+        out.Put("\t\tlocal x = 0, y = 0, z = 0;\n");
+    }
+    out.Put("\t\tfor (local i = 0; i < pos.len(); i += 3)\n\t\t{\n\t\t\t");
+    if (delta)
+    {
+        out.Put("x += pos[i];\n\t\t\ty += pos[i + 1];\n\t\t\tz += pos[i + 2];\n\t\t\t");
+        out.Put(func);
+        out.Put("(id, x, y, z);\n");
+    }
+    else
+    {
+        out.Put(func);
+        out.Put("(id, pos[i], pos[i + 1], pos[i + 2]);\n");
+    }
+    out.Put("\t\t}\n\t}\n}\n");
+    // Report whether the output could be written
+    return !out.Failed();
+}
+
+// ------------------------------------------------------------------------------------------------
+bool BuildGrid(Format fmt, const Instances & inst_list, const char * func, double size,
+                Writer & out, const Progress & progress)
+{
+    // Empty lists generate nothing, just like the other script formats
+    if (inst_list.empty())
+    {
+        return !out.Failed();
+    }
+    const size_t n = inst_list.size();
+    // Whether the adjusted coordinates are used
+    const bool raw = (fmt == Format::GRAW);
+    // The adjusted coordinates of each instance, if used
+    std::vector< int32_t > quant(raw ? n * 3 : 0);
+    if (raw)
+    {
+        QuantizePositions(inst_list.data(), n, quant.data());
+    }
+    // Find the cell of every instance
+    std::vector< CellEntry > cells(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const Instance & inst = inst_list[i];
+        cells[i] = CellEntry{CellOf(inst.mX, size), CellOf(inst.mY, size),
+                                static_cast< uint32_t >(i)};
+    }
+    // Bring the instances of each cell together, keeping their original order
+    std::sort(cells.begin(), cells.end());
+    // The table is named after the function so that grids for different functions can coexist
+    out.Put(func);
+    out.Put("Grid <- {\n\tsize = ");
+    out.Put(size);
+    out.Put(",\n\tcells = {\n");
+    // Generate a table for each column of cells with an array for each cell in it
+    for (size_t i = 0; i < n; )
+    {
+        const int32_t cx = cells[i].mX;
+        out.Put("\t\t[");
+        out.Put(static_cast< int >(cx));
+        out.Put("] = {\n");
+        // Process every cell in this column
+        while (i < n && cells[i].mX == cx)
+        {
+            const int32_t cy = cells[i].mY;
+            out.Put("\t\t\t[");
+            out.Put(static_cast< int >(cy));
+            out.Put("] = [");
+            // Process every instance in this cell
+            for (size_t k = 0; i < n && cells[i].mX == cx && cells[i].mY == cy; ++i, ++k)
+            {
+                // Let the caller know how far we got and whether we should continue
+                if ((i % ProgressStep) == 0 && progress && !progress(i, n))
+                {
+                    return false; // Cancelled!
+                }
+                // Keep the lines reasonably short
+                out.Put(k % TableRowSize == 0 ? "\n\t\t\t\t" : " ");
+                // Generate the model and the position
+                const uint32_t r = cells[i].mIndex;
+                const Instance & inst = inst_list[r];
+                out.Put(inst.mID);
+                out.Put(',');
+                for (unsigned a = 0; a < 3; ++a)
+                {
+                    if (raw)
+                    {
+                        out.Put(static_cast< int >(quant[r * 3 + a]));
+                    }
+                    else
+                    {
+                        out.Put(a == 0 ? inst.mX : (a == 1 ? inst.mY : inst.mZ));
+                    }
+                    out.Put(',');
+                }
+            }
+            out.Put("\n\t\t\t],\n");
+        }
+        out.Put("\t\t},\n");
+    }
+    // Generate the function that processes the cells near a point, each of them only once
+    out.Put("\t},\n\tfunction Apply(x, y, radius)\n\t{\n");
+    out.Put("\t\tlocal x0 = floor((x - radius) / size).tointeger();\n");
+    out.Put("\t\tlocal x1 = floor((x + radius) / size).tointeger();\n");
+    out.Put("\t\tlocal y0 = floor((y - radius) / size).tointeger();\n");
+    out.Put("\t\tlocal y1 = floor((y + radius) / size).tointeger();\n");
+    out.Put("\t\tfor (local cx = x0; cx <= x1; ++cx)\n\t\t{\n");
+    out.Put("\t\t\tif (!(cx in cells)) continue;\n");
+    out.Put("\t\t\tlocal column = cells[cx];\n");
+    out.Put("\t\t\tfor (local cy = y0; cy <= y1; ++cy)\n\t\t\t{\n");
+    out.Put("\t\t\t\tif (!(cy in column)) continue;\n");
+    out.Put("\t\t\t\tlocal pos = column[cy];\n");
+    out.Put("\t\t\t\tfor (local i = 0; i < pos.len(); i += 4)\n\t\t\t\t{\n\t\t\t\t\t");
+    out.Put(func);
+    out.Put("(pos[i], pos[i + 1], pos[i + 2], pos[i + 3]);\n\t\t\t\t}\n");
+    out.Put("\t\t\t\tdelete column[cy];\n\t\t\t}\n\t\t}\n\t}\n};\n");
+    // Report whether the output could be written
+    return !out.Failed();
+}
+
+// ------------------------------------------------------------------------------------------------
+bool BuildBIN(const Instances & inst_list, Writer & out, const Progress & progress)
+{
+    // Store a 32-bit value in little endian order
+    auto store = [](unsigned char * p, uint32_t v) {
+        p[0] = static_cast< unsigned char >(v), p[1] = static_cast< unsigned char >(v >> 8);
+        p[2] = static_cast< unsigned char >(v >> 16), p[3] = static_cast< unsigned char >(v >> 24);
+    };
+    // Generate the header
+    unsigned char header[sizeof(HideHeader)];
+    std::memcpy(header, HideMagic, sizeof(HideMagic));
+    store(header + 8, HideVersion);
+    store(header + 12, static_cast< uint32_t >(inst_list.size()));
+    out.Put(reinterpret_cast< const char * >(header), sizeof(header));
+    // The quantized positions of the block being generated
+    int32_t quant[QuantizeBlock * 3];
+    // Process all instances in the list, one block at a time
+    for (size_t base = 0, n = inst_list.size(); base < n; base += QuantizeBlock)
+    {
+        const size_t count = std::min(QuantizeBlock, n - base);
+        // Quantize the whole block at once
+        QuantizePositions(inst_list.data() + base, count, quant);
+        // Generate the records of the block
+        for (size_t i = base, k = 0; k < count; ++i, ++k)
+        {
+            // Let the caller know how far we got and whether we should continue
+            if ((i % ProgressStep) == 0 && progress && !progress(i, n))
+            {
+                return false; // Cancelled!
+            }
+            // Generate the record with the computed coordinates
+            unsigned char record[sizeof(HideRecord)];
+            store(record, static_cast< uint32_t >(inst_list[i].mID));
+            store(record + 4, static_cast< uint32_t >(quant[k * 3]));
+            store(record + 8, static_cast< uint32_t >(quant[k * 3 + 1]));
+            store(record + 12, static_cast< uint32_t >(quant[k * 3 + 2]));
+            out.Put(reinterpret_cast< const char * >(record), sizeof(record));
+        }
+    }
+    // Report whether the output could be written
+    return !out.Failed();
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Build(Format fmt, const Instances & inst_list, const char * func, Writer & out,
+           const Progress & progress)
+{
+    switch (fmt)
+    {
+        case Format::XML: return BuildXML(inst_list, out, progress);
+        case Format::NUT: return BuildNUT(inst_list, func, out, progress);
+        case Format::RAW: return BuildRAW(inst_list, func, out, progress);
+        case Format::BIN: return BuildBIN(inst_list, out, progress);
+        case Format::TNUT:
+        case Format::TRAW:
+        case Format::DELTA: return BuildTable(fmt, inst_list, func, out, progress);
+        case Format::GNUT:
+        case Format::GRAW: return BuildGrid(fmt, inst_list, func, DefaultGridSize, out, progress);
+    }
+    // Should not be reached
+    return false;
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,117 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+#include "Writer.hpp"
+#include "Progress.hpp"
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+static constexpr double DefaultGridSize = 250.0; // Size of the map cells in grid output
+
+/* ------------------------------------------------------------------------------------------------
+ * The kind of output that can be generated from a list of instances.
+*/
+enum class Format
+{
+    XML, // XML map rules
+    NUT, // Script function calls with unmodified coordinates
+    RAW, // Script function calls with adjusted coordinates
+    BIN, // Binary hide list with adjusted coordinates
+    TNUT, // Script tables grouped by model with unmodified coordinates
+    TRAW, // Script tables grouped by model with adjusted coordinates
+    DELTA, // Script tables grouped by model with delta encoded adjusted coordinates
+    GNUT, // Script tables grouped by map cell with unmodified coordinates
+    GRAW // Script tables grouped by map cell with adjusted coordinates
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * See whether the format produces binary data. Binary output holds a single table, so it cannot
+ * be displayed or generated separately for each file and joined afterwards.
+*/
+inline bool IsBinary(Format fmt)
+{
+    return fmt == Format::BIN;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * See whether the format produces script tables instead of one piece of output per instance.
+ * Such output is not generated through a template and cannot be displayed one row at a time.
+*/
+inline bool IsTable(Format fmt)
+{
+    return fmt == Format::TNUT || fmt == Format::TRAW || fmt == Format::DELTA ||
+            fmt == Format::GNUT || fmt == Format::GRAW;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * See whether the format groups instances by map cell. The cells hold instances from every file,
+ * so the output cannot be generated separately for each file and joined afterwards.
+*/
+inline bool IsGrid(Format fmt)
+{
+    return fmt == Format::GNUT || fmt == Format::GRAW;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the template that generates the specified text format. Null for binary formats and
+ * script tables.
+*/
+const char * FormatTemplate(Format fmt);
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the format identified by the specified name. (case insensitive)
+*/
+bool FormatFromName(const char * name, Format & fmt);
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate XML output from the specified instances.
+*/
+bool BuildXML(const Instances & inst_list, Writer & out,
+              const Progress & progress = Progress());
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate NUT output from the specified instances.
+*/
+bool BuildNUT(const Instances & inst_list, const char * func, Writer & out,
+              const Progress & progress = Progress());
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate RAW NUT output from the specified instances.
+*/
+bool BuildRAW(const Instances & inst_list, const char * func, Writer & out,
+              const Progress & progress = Progress());
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate script tables from the specified instances. The instances are grouped by model into
+ * array literals and a single loop invokes the function for each of them, which makes the same
+ * calls as the NUT or RAW output with far less code for the script engine to compile.
+*/
+bool BuildTable(Format fmt, const Instances & inst_list, const char * func, Writer & out,
+                const Progress & progress = Progress());
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate a script table that places the instances in a grid of square map cells of the
+ * specified size. Each cell holds an array with the model and position of its instances, and the
+ * table provides a function that invokes the function for the cells within a distance of a point,
+ * so the script only has to process the parts of the map that players are near.
+*/
+bool BuildGrid(Format fmt, const Instances & inst_list, const char * func, double size,
+                Writer & out, const Progress & progress = Progress());
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate a binary hide list from the specified instances.
+*/
+bool BuildBIN(const Instances & inst_list, Writer & out,
+              const Progress & progress = Progress());
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate the output of the specified format. The progress is measured in instances. Grid output
+ * uses the default cell size.
+*/
+bool Build(Format fmt, const Instances & inst_list, const char * func, Writer & out,
+           const Progress & progress = Progress());
+
+} // Namespace:: VcMp
@@ -0,0 +1,636 @@
+// ------------------------------------------------------------------------------------------------
+#include "BulkReader.hpp"
+#include "Diagnostics.hpp"
+#include "Parallel.hpp"
+#include "Queue.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#ifdef _WIN32
+    #include <cstdio>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define VCMP_URING
+        #include <cstring>
+        #include <cstdint>
+        #include <sys/mman.h>
+        #include <sys/syscall.h>
+        #include <linux/io_uring.h>
+    #endif
+#endif
+
+// ------------------------------------------------------------------------------------------------
+#include <thread>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+const unsigned RingDepth = 64; // Files being opened or read at once through io_uring
+const size_t ReadBudget = 256 * 1024 * 1024; // Bytes being read at once through io_uring
+const size_t ReadChunk = 1024 * 1024 * 1024; // Largest single read request
+
+/* ------------------------------------------------------------------------------------------------
+ * Read a whole file with plain reads.
+*/
+void ReadWhole(const char * path, LoadedFile & file)
+{
+    Stopwatch watch;
+#ifdef _WIN32
+    std::FILE * fp = nullptr;
+    // Attempt to open the specified file
+    if (fopen_s(&fp, path, "rb") != 0 || fp == nullptr)
+    {
+        return; // Nothing to read
+    }
+    // Retrieve the file size
+    _fseeki64(fp, 0, SEEK_END);
+    const __int64 size = _ftelli64(fp);
+    _fseeki64(fp, 0, SEEK_SET);
+    // Read the whole contents at once
+    if (size >= 0)
+    {
+        file.mData.reset(new char[size > 0 ? static_cast< size_t >(size) : 1]);
+        file.mSize = std::fread(file.mData.get(), 1, static_cast< size_t >(size), fp);
+        file.mOpen = !std::ferror(fp);
+    }
+    std::fclose(fp);
+#else
+    // Attempt to open the specified file
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return; // Nothing to read
+    }
+    struct stat st;
+    // Retrieve the file size and make sure this is something we can read
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        const size_t size = static_cast< size_t >(st.st_size);
+        file.mData.reset(new char[size > 0 ? size : 1]);
+        file.mOpen = true;
+        // Keep reading until everything arrived or the file ends early
+        while (file.mSize < size)
+        {
+            const ssize_t n = pread(fd, file.mData.get() + file.mSize, size - file.mSize,
+                                    static_cast< off_t >(file.mSize));
+            // Was the read interrupted?
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            // Did it fail or did the file get shorter?
+            else if (n <= 0)
+            {
+                file.mOpen = (n == 0);
+                break;
+            }
+            file.mSize += static_cast< size_t >(n);
+        }
+    }
+    close(fd);
+#endif
+    file.mSeconds = watch.Lap();
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Read every file on the workers that process them.
+*/
+void ReadPlain(const std::vector< std::string > & paths, unsigned jobs,
+                const FileHandler & handler)
+{
+    ParallelFor(paths.size(), jobs, [&](size_t i) {
+        LoadedFile file;
+        file.mIndex = i;
+        ReadWhole(paths[i].c_str(), file);
+        handler(file);
+    });
+}
+
+#ifdef VCMP_URING
+
+/* ------------------------------------------------------------------------------------------------
+ * Submission and completion queues shared with the kernel. Only used from a single thread.
+*/
+class Ring
+{
+private:
+
+    // --------------------------------------------------------------------------------------------
+    int             m_Fd; // The io_uring instance
+    void *          m_SqMap; // Mapped submission queue
+    size_t          m_SqSize; // Size of the mapped submission queue
+    void *          m_CqMap; // Mapped completion queue (may be the same as the submission queue)
+    size_t          m_CqSize; // Size of the mapped completion queue
+    io_uring_sqe *  m_Sqes; // Mapped submission entries
+    size_t          m_SqesSize; // Size of the mapped submission entries
+    unsigned *      m_SqTail; // Where the next submission goes
+    unsigned *      m_SqMask; // Turns a position into a submission index
+    unsigned *      m_SqArray; // Submission entries in the order they are submitted
+    unsigned *      m_CqHead; // Next completion to take out
+    unsigned *      m_CqTail; // Where the kernel places the next completion
+    unsigned *      m_CqMask; // Turns a position into a completion index
+    io_uring_cqe *  m_Cqes; // Mapped completion entries
+    unsigned        m_Pending; // Entries that were not submitted yet
+    uint64_t        m_Submitted; // Entries handed to the kernel so far
+    uint64_t        m_Completed; // Completions taken out so far
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Default constructor.
+    */
+    Ring()
+        : m_Fd(-1), m_SqMap(MAP_FAILED), m_SqSize(0), m_CqMap(MAP_FAILED), m_CqSize(0)
+        , m_Sqes(nullptr), m_SqesSize(0), m_SqTail(nullptr), m_SqMask(nullptr), m_SqArray(nullptr)
+        , m_CqHead(nullptr), m_CqTail(nullptr), m_CqMask(nullptr), m_Cqes(nullptr), m_Pending(0)
+        , m_Submitted(0), m_Completed(0)
+    {
+        /* ... */
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy constructor. (disabled)
+    */
+    Ring(const Ring &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Destructor. Releases the queues.
+    */
+    ~Ring()
+    {
+        if (m_Sqes != nullptr)
+        {
+            munmap(m_Sqes, m_SqesSize);
+        }
+        if (m_CqMap != MAP_FAILED && m_CqMap != m_SqMap)
+        {
+            munmap(m_CqMap, m_CqSize);
+        }
+        if (m_SqMap != MAP_FAILED)
+        {
+            munmap(m_SqMap, m_SqSize);
+        }
+        if (m_Fd >= 0)
+        {
+            close(m_Fd);
+        }
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy assignment operator. (disabled)
+    */
+    Ring & operator = (const Ring &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Set up the queues with room for the specified number of entries. Fails if io_uring is not
+     * available or does not know every operation used to read files.
+    */
+    bool Open(unsigned entries)
+    {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        // Create the instance
+        m_Fd = static_cast< int >(syscall(__NR_io_uring_setup, entries, &p));
+        if (m_Fd < 0)
+        {
+            return false;
+        }
+        // Make sure every operation we need is known
+        std::vector< char > buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+        io_uring_probe * probe = reinterpret_cast< io_uring_probe * >(buffer.data());
+        if (syscall(__NR_io_uring_register, m_Fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+        {
+            return false;
+        }
+        for (unsigned op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE})
+        {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+            {
+                return false;
+            }
+        }
+        // Map the queues, which may share a single mapping
+        m_SqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_CqSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        if (p.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            m_SqSize = m_CqSize = std::max(m_SqSize, m_CqSize);
+        }
+        m_SqMap = mmap(nullptr, m_SqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_Fd, IORING_OFF_SQ_RING);
+        if (m_SqMap == MAP_FAILED)
+        {
+            return false;
+        }
+        m_CqMap = (p.features & IORING_FEAT_SINGLE_MMAP) ? m_SqMap
+                : mmap(nullptr, m_CqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_Fd, IORING_OFF_CQ_RING);
+        if (m_CqMap == MAP_FAILED)
+        {
+            return false;
+        }
+        m_SqesSize = p.sq_entries * sizeof(io_uring_sqe);
+        void * sqes = mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            m_Fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+        {
+            return false;
+        }
+        m_Sqes = static_cast< io_uring_sqe * >(sqes);
+        // Locate the fields of each queue
+        char * sq = static_cast< char * >(m_SqMap), * cq = static_cast< char * >(m_CqMap);
+        m_SqTail = reinterpret_cast< unsigned * >(sq + p.sq_off.tail);
+        m_SqMask = reinterpret_cast< unsigned * >(sq + p.sq_off.ring_mask);
+        m_SqArray = reinterpret_cast< unsigned * >(sq + p.sq_off.array);
+        m_CqHead = reinterpret_cast< unsigned * >(cq + p.cq_off.head);
+        m_CqTail = reinterpret_cast< unsigned * >(cq + p.cq_off.tail);
+        m_CqMask = reinterpret_cast< unsigned * >(cq + p.cq_off.ring_mask);
+        m_Cqes = reinterpret_cast< io_uring_cqe * >(cq + p.cq_off.cqes);
+        // The queues are ready
+        return true;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Claim the next submission entry. The entry is only seen by the kernel once it was filled in
+     * and published. The caller never has more entries in flight than the queue was created with.
+    */
+    io_uring_sqe & Next(uint64_t data)
+    {
+        io_uring_sqe & sqe = m_Sqes[*m_SqTail & *m_SqMask];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.user_data = data;
+        // Let the caller fill it in
+        return sqe;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Hand the entry claimed by Next() to the kernel.
+    */
+    void Publish()
+    {
+        const unsigned tail = *m_SqTail, idx = tail & *m_SqMask;
+        m_SqArray[idx] = idx;
+        // The entry must be complete before the kernel can see the new tail
+        __atomic_store_n(m_SqTail, tail + 1, __ATOMIC_RELEASE);
+        ++m_Pending;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Submit the claimed entries, if requested, and wait until at least one operation completed.
+    */
+    bool Enter(bool submit = true)
+    {
+        for (;;)
+        {
+            const long n = syscall(__NR_io_uring_enter, m_Fd, submit ? m_Pending : 0, 1,
+                                    IORING_ENTER_GETEVENTS, nullptr, 0);
+            // Was the wait interrupted?
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            else if (n < 0)
+            {
+                return false;
+            }
+            m_Pending -= static_cast< unsigned >(n);
+            m_Submitted += static_cast< uint64_t >(n);
+            // The entries were submitted
+            return true;
+        }
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of submitted operations whose completion was not taken out yet.
+    */
+    uint64_t InFlight() const
+    {
+        return m_Submitted - m_Completed;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Take out the next completion, if any.
+    */
+    bool Pop(uint64_t & data, int & res)
+    {
+        const unsigned head = *m_CqHead;
+        // Is there anything to take out?
+        if (head == __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE))
+        {
+            return false;
+        }
+        const io_uring_cqe & cqe = m_Cqes[head & *m_CqMask];
+        data = cqe.user_data, res = cqe.res;
+        // Give the entry back to the kernel
+        __atomic_store_n(m_CqHead, head + 1, __ATOMIC_RELEASE);
+        ++m_Completed;
+        // A completion was taken out
+        return true;
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * A file being read through io_uring.
+*/
+struct Slot
+{
+    /* --------------------------------------------------------------------------------------------
+     * The operation the slot waits for.
+    */
+    enum class Step
+    {
+        Free, // Not used by any file
+        Open, // Waiting for the file to be opened
+        Read, // Waiting for the contents
+        Close // Waiting for the file to be closed
+    };
+
+    // --------------------------------------------------------------------------------------------
+    Step        mStep = Step::Free; // The operation the slot waits for
+    LoadedFile  mFile; // The file being read
+    size_t      mExpected = 0; // Size of the file when it was opened
+    int         mFd = -1; // The opened file, until closing it completed
+    Stopwatch   mWatch; // Measures the time it takes to read the file
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Read every file through io_uring and hand them over as they complete. Returns false without
+ * doing anything if io_uring can't be used. Files left over when the queues stop working are
+ * read with plain reads once every running operation completed.
+*/
+bool ReadRing(const std::vector< std::string > & paths, Queue< LoadedFile > & ready)
+{
+    Ring ring;
+    // Can we use io_uring at all?
+    if (!ring.Open(RingDepth))
+    {
+        return false;
+    }
+    std::vector< Slot > slots(RingDepth);
+    // The next file to start on, the slots in use and the bytes being read
+    size_t next = 0, active = 0, bytes = 0;
+    // Request the next part of the contents
+    auto read = [&ring](Slot & s, size_t id) {
+        io_uring_sqe & sqe = ring.Next(id);
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = s.mFd;
+        sqe.addr = reinterpret_cast< uint64_t >(s.mFile.mData.get() + s.mFile.mSize);
+        sqe.len = static_cast< uint32_t >(std::min(s.mExpected - s.mFile.mSize, ReadChunk));
+        sqe.off = s.mFile.mSize;
+        ring.Publish();
+        s.mStep = Slot::Step::Read;
+    };
+    // Hand over the file and release what it holds
+    auto finish = [&](Slot & s, size_t id, bool open) {
+        s.mFile.mOpen = open;
+        s.mFile.mSeconds = s.mWatch.Lap();
+        bytes -= s.mExpected;
+        ready.Push(std::move(s.mFile));
+        s.mFile = LoadedFile();
+        s.mExpected = 0;
+        // Close the file if it was opened
+        if (s.mFd >= 0)
+        {
+            io_uring_sqe & sqe = ring.Next(id);
+            sqe.opcode = IORING_OP_CLOSE;
+            sqe.fd = s.mFd;
+            ring.Publish();
+            s.mStep = Slot::Step::Close;
+        }
+        else
+        {
+            s.mStep = Slot::Step::Free;
+            --active;
+        }
+    };
+    for (;;)
+    {
+        // Start on more files while there are free slots and memory to read them into
+        for (size_t id = 0; id < slots.size() && next < paths.size(); ++id)
+        {
+            Slot & s = slots[id];
+            // Is the slot available and is there room for more data?
+            if (s.mStep != Slot::Step::Free || (bytes >= ReadBudget && active > 0))
+            {
+                continue;
+            }
+            s.mFile.mIndex = next;
+            s.mWatch = Stopwatch();
+            io_uring_sqe & sqe = ring.Next(id);
+            sqe.opcode = IORING_OP_OPENAT;
+            sqe.fd = AT_FDCWD;
+            sqe.addr = reinterpret_cast< uint64_t >(paths[next++].c_str());
+            sqe.open_flags = O_RDONLY | O_CLOEXEC;
+            ring.Publish();
+            s.mStep = Slot::Step::Open;
+            ++active;
+        }
+        // Is there anything left to do?
+        if (active == 0)
+        {
+            break;
+        }
+        // Wait for something to complete
+        else if (!ring.Enter())
+        {
+            break;
+        }
+        uint64_t id;
+        int res;
+        // Move every completed file along
+        while (ring.Pop(id, res))
+        {
+            Slot & s = slots[id];
+            // Process the result of the operation
+            switch (s.mStep)
+            {
+                case Slot::Step::Open:
+                {
+                    struct stat st;
+                    // Did the file open? Is it something we can read?
+                    if (res < 0 || (s.mFd = res, fstat(s.mFd, &st) != 0) || !S_ISREG(st.st_mode))
+                    {
+                        finish(s, id, false);
+                        break;
+                    }
+                    s.mExpected = static_cast< size_t >(st.st_size);
+                    s.mFile.mData.reset(new char[s.mExpected > 0 ? s.mExpected : 1]);
+                    bytes += s.mExpected;
+                    // Empty files are perfectly valid
+                    if (s.mExpected == 0)
+                    {
+                        finish(s, id, true);
+                    }
+                    else
+                    {
+                        read(s, id);
+                    }
+                } break;
+                case Slot::Step::Read:
+                {
+                    // Was the read interrupted?
+                    if (res == -EINTR || res == -EAGAIN)
+                    {
+                        read(s, id);
+                        break;
+                    }
+                    // Did it fail or did the file get shorter?
+                    else if (res <= 0)
+                    {
+                        finish(s, id, res == 0);
+                        break;
+                    }
+                    s.mFile.mSize += static_cast< size_t >(res);
+                    // Is there anything left to read?
+                    if (s.mFile.mSize < s.mExpected)
+                    {
+                        read(s, id);
+                    }
+                    else
+                    {
+                        finish(s, id, true);
+                    }
+                } break;
+                case Slot::Step::Close:
+                {
+                    s.mFd = -1;
+                    s.mStep = Slot::Step::Free;
+                    --active;
+                } break;
+                case Slot::Step::Free: break;
+            }
+        }
+    }
+    // The queues may have stopped working with operations still running. Their buffers and files
+    // can only be released once the kernel is done with them
+    bool drained = true;
+    while (drained)
+    {
+        uint64_t id;
+        int res;
+        // Only keep track of the files, since everything unfinished is read again
+        while (ring.Pop(id, res))
+        {
+            Slot & s = slots[id];
+            if (s.mStep == Slot::Step::Open && res >= 0)
+            {
+                s.mFd = res;
+            }
+            else if (s.mStep == Slot::Step::Close)
+            {
+                s.mFd = -1;
+                s.mStep = Slot::Step::Free;
+            }
+        }
+        // Is anything still running?
+        if (ring.InFlight() == 0)
+        {
+            break;
+        }
+        // Wait without submitting anything new
+        drained = ring.Enter(false);
+    }
+    // Files that the queues did not finish with are read again with plain reads
+    for (auto & s : slots)
+    {
+        // Was this file still being opened or read?
+        if (s.mStep == Slot::Step::Open || s.mStep == Slot::Step::Read)
+        {
+            LoadedFile file;
+            file.mIndex = s.mFile.mIndex;
+            ReadWhole(paths[file.mIndex].c_str(), file);
+            ready.Push(std::move(file));
+        }
+        // The kernel may still be using the buffer and the file if the operations could not be
+        // waited for, so they are given up rather than released under it
+        if (!drained)
+        {
+            s.mFile.mData.release();
+        }
+        else if (s.mFd >= 0)
+        {
+            close(s.mFd);
+        }
+        s.mFd = -1;
+    }
+    // Files that never made it into the queues are read the same way
+    for (; next < paths.size(); ++next)
+    {
+        LoadedFile file;
+        file.mIndex = next;
+        ReadWhole(paths[next].c_str(), file);
+        ready.Push(std::move(file));
+    }
+    // Every file was handed over
+    return true;
+}
+
+#endif // VCMP_URING
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+void ReadFiles(const std::vector< std::string > & paths, unsigned jobs,
+                const FileHandler & handler)
+{
+    jobs = std::max(jobs, 1u);
+#ifdef VCMP_URING
+    // Files that were read and wait to be processed
+    Queue< LoadedFile > ready(jobs * 2);
+    // Process the files as they arrive
+    std::vector< std::thread > pool;
+    pool.reserve(jobs);
+    for (unsigned n = 0; n < jobs; ++n)
+    {
+        pool.emplace_back([&]() {
+            for (LoadedFile file; ready.Pop(file); )
+            {
+                handler(file);
+            }
+        });
+    }
+    // Read the files on this thread
+    const bool queued = ReadRing(paths, ready);
+    ready.Close();
+    // Wait for everyone to finish
+    for (auto & t : pool)
+    {
+        t.join();
+    }
+    // Did io_uring do the job?
+    if (queued)
+    {
+        return;
+    }
+#endif
+    // Let every worker read its own files
+    ReadPlain(paths, jobs, handler);
+}
+
+// ------------------------------------------------------------------------------------------------
+const char * ReadMethod()
+{
+#ifdef VCMP_URING
+    static const bool uring = Ring().Open(RingDepth);
+    // Return the method that ReadFiles() uses
+    return uring ? "io_uring" : "pread";
+#elif defined(_WIN32)
+    return "read";
+#else
+    return "pread";
+#endif
+}
+
+} // Namespace:: VcMp
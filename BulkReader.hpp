@@ -0,0 +1,47 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * A whole file read into memory.
+*/
+struct LoadedFile
+{
+    // --------------------------------------------------------------------------------------------
+    size_t                      mIndex = 0; // Position of the file in the list
+    std::unique_ptr< char[] >   mData; // Contents of the file
+    size_t                      mSize = 0; // Size of the contents
+    double                      mSeconds = 0.0; // Time from opening the file until it was read
+    bool                        mOpen = false; // Whether the file could be read
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Receives a file that was read.
+*/
+typedef std::function< void (LoadedFile & file) > FileHandler;
+
+/* ------------------------------------------------------------------------------------------------
+ * Read every file in the list and hand each one to the handler on one of the workers as soon as
+ * it was read, in no particular order. On Linux the files are opened and read through io_uring
+ * with many of them in flight at once, so the disk always has work queued while the workers
+ * parse. Elsewhere, or when io_uring is not available, each worker reads its next file itself.
+*/
+void ReadFiles(const std::vector< std::string > & paths, unsigned jobs,
+                const FileHandler & handler);
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the name of the method used to read files in bulk.
+*/
+const char * ReadMethod();
+
+} // Namespace:: VcMp
@@ -0,0 +1,418 @@
+// ------------------------------------------------------------------------------------------------
+#include "Columns.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <limits>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define VCMP_FILTER_X86
+    #define VCMP_TARGET(isa) __attribute__((target(isa)))
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define VCMP_FILTER_X86
+    #define VCMP_TARGET(isa)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * Mark which of 64 rows are inside the bounds. Bit N belongs to row N.
+*/
+typedef uint64_t (*Bounder)(const double * x, const double * y, const double * z,
+                            const double * lo, const double * hi);
+
+/* ------------------------------------------------------------------------------------------------
+ * Portable bounds kernel.
+*/
+uint64_t BoundsScalar(const double * x, const double * y, const double * z,
+                        const double * lo, const double * hi)
+{
+    uint64_t mask = 0;
+    // Process one row at a time
+    for (unsigned i = 0; i < 64; ++i)
+    {
+        const bool in = (x[i] >= lo[0]) & (x[i] <= hi[0]) & (y[i] >= lo[1]) & (y[i] <= hi[1]) &
+                        (z[i] >= lo[2]) & (z[i] <= hi[2]);
+        mask |= static_cast< uint64_t >(in) << i;
+    }
+    // Return the rows that are inside
+    return mask;
+}
+
+#ifdef VCMP_FILTER_X86
+
+/* ------------------------------------------------------------------------------------------------
+ * Bounds kernel that processes 2 rows at a time.
+*/
+VCMP_TARGET("sse2") uint64_t BoundsSSE2(const double * x, const double * y, const double * z,
+                                        const double * lo, const double * hi)
+{
+    const __m128d lx = _mm_set1_pd(lo[0]), ly = _mm_set1_pd(lo[1]), lz = _mm_set1_pd(lo[2]);
+    const __m128d hx = _mm_set1_pd(hi[0]), hy = _mm_set1_pd(hi[1]), hz = _mm_set1_pd(hi[2]);
+    uint64_t mask = 0;
+    // Process 2 rows at a time
+    for (unsigned i = 0; i < 64; i += 2)
+    {
+        const __m128d vx = _mm_loadu_pd(x + i), vy = _mm_loadu_pd(y + i);
+        const __m128d vz = _mm_loadu_pd(z + i);
+        // Compare every axis against both bounds
+        __m128d m = _mm_and_pd(_mm_cmpge_pd(vx, lx), _mm_cmple_pd(vx, hx));
+        m = _mm_and_pd(m, _mm_and_pd(_mm_cmpge_pd(vy, ly), _mm_cmple_pd(vy, hy)));
+        m = _mm_and_pd(m, _mm_and_pd(_mm_cmpge_pd(vz, lz), _mm_cmple_pd(vz, hz)));
+        // Store the resulted bits
+        mask |= static_cast< uint64_t >(_mm_movemask_pd(m)) << i;
+    }
+    // Return the rows that are inside
+    return mask;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Bounds kernel that processes 4 rows at a time.
+*/
+VCMP_TARGET("avx2") uint64_t BoundsAVX2(const double * x, const double * y, const double * z,
+                                        const double * lo, const double * hi)
+{
+    const __m256d lx = _mm256_set1_pd(lo[0]), ly = _mm256_set1_pd(lo[1]);
+    const __m256d lz = _mm256_set1_pd(lo[2]), hx = _mm256_set1_pd(hi[0]);
+    const __m256d hy = _mm256_set1_pd(hi[1]), hz = _mm256_set1_pd(hi[2]);
+    uint64_t mask = 0;
+    // Process 4 rows at a time
+    for (unsigned i = 0; i < 64; i += 4)
+    {
+        const __m256d vx = _mm256_loadu_pd(x + i), vy = _mm256_loadu_pd(y + i);
+        const __m256d vz = _mm256_loadu_pd(z + i);
+        // Compare every axis against both bounds (ordered, so NaN is never inside)
+        __m256d m = _mm256_and_pd(_mm256_cmp_pd(vx, lx, _CMP_GE_OQ),
+                                    _mm256_cmp_pd(vx, hx, _CMP_LE_OQ));
+        m = _mm256_and_pd(m, _mm256_and_pd(_mm256_cmp_pd(vy, ly, _CMP_GE_OQ),
+                                            _mm256_cmp_pd(vy, hy, _CMP_LE_OQ)));
+        m = _mm256_and_pd(m, _mm256_and_pd(_mm256_cmp_pd(vz, lz, _CMP_GE_OQ),
+                                            _mm256_cmp_pd(vz, hz, _CMP_LE_OQ)));
+        // Store the resulted bits
+        mask |= static_cast< uint64_t >(_mm256_movemask_pd(m)) << i;
+    }
+    // Return the rows that are inside
+    return mask;
+}
+
+#endif // VCMP_FILTER_X86
+
+/* ------------------------------------------------------------------------------------------------
+ * A bounds kernel and its name.
+*/
+struct KernelInfo
+{
+    // --------------------------------------------------------------------------------------------
+    Bounder         mFn; // The kernel function
+    const char *    mName; // The kernel name
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Pick the widest kernel supported by the CPU.
+*/
+KernelInfo SelectKernel()
+{
+#if defined(VCMP_FILTER_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    // Look for the widest supported instruction set
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return {&BoundsAVX2, "avx2"};
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        return {&BoundsSSE2, "sse2"};
+    }
+#elif defined(VCMP_FILTER_X86)
+    int info[4];
+    __cpuid(info, 1);
+    // AVX2 also needs the OS to preserve the wide registers
+    const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+    {
+        __cpuidex(info, 7, 0);
+        // Look for the extended feature bit
+        if ((info[1] & (1 << 5)) != 0)
+        {
+            return {&BoundsAVX2, "avx2"};
+        }
+    }
+    if (sse2)
+    {
+        return {&BoundsSSE2, "sse2"};
+    }
+#endif
+    // Nothing better is available
+    return {&BoundsScalar, "scalar"};
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the kernel selected for this CPU.
+*/
+const KernelInfo & Selected()
+{
+    static const KernelInfo k = SelectKernel();
+    // Return the selected kernel
+    return k;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the index of the lowest set bit in a non-zero mask.
+*/
+inline unsigned LowestBit(uint64_t m)
+{
+#if defined(__GNUC__)
+    return static_cast< unsigned >(__builtin_ctzll(m));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanForward64(&idx, m);
+    return static_cast< unsigned >(idx);
+#else
+    unsigned idx = 0;
+    while ((m & 1) == 0)
+    {
+        m >>= 1, ++idx;
+    }
+    return idx;
+#endif
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * A set of model identifiers stored as one bit per identifier between the lowest and highest.
+ * Sets that span too many identifiers for that are kept sorted and searched instead.
+*/
+class ModelSet
+{
+    // --------------------------------------------------------------------------------------------
+    static constexpr size_t MaxWords = 8192; // Largest bit set (64 KB, 524288 identifiers)
+
+    // --------------------------------------------------------------------------------------------
+    int64_t                 m_Min = 0; // Lowest identifier in the set
+    std::vector< uint64_t > m_Bits; // One bit per identifier from the lowest one
+    std::vector< int32_t >  m_Sparse; // Sorted identifiers when the span is too wide for bits
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor.
+    */
+    explicit ModelSet(const std::vector< int > & ids)
+    {
+        if (ids.empty())
+        {
+            return;
+        }
+        const auto range = std::minmax_element(ids.begin(), ids.end());
+        m_Min = *range.first;
+        const uint64_t words = static_cast< uint64_t >(*range.second - m_Min) / 64 + 1;
+        // Are the identifiers too far apart for a bit set?
+        if (words > MaxWords)
+        {
+            m_Sparse.assign(ids.begin(), ids.end());
+            std::sort(m_Sparse.begin(), m_Sparse.end());
+            m_Sparse.erase(std::unique(m_Sparse.begin(), m_Sparse.end()), m_Sparse.end());
+            // We're done here
+            return;
+        }
+        m_Bits.assign(static_cast< size_t >(words), 0);
+        // Set the bit of every identifier
+        for (int id : ids)
+        {
+            const uint64_t n = static_cast< uint64_t >(id - m_Min);
+            m_Bits[n / 64] |= static_cast< uint64_t >(1) << (n % 64);
+        }
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether the specified identifier is in the set.
+    */
+    bool Has(int32_t id) const
+    {
+        // Is the set kept sorted?
+        if (!m_Sparse.empty())
+        {
+            return std::binary_search(m_Sparse.begin(), m_Sparse.end(), id);
+        }
+        const uint64_t n = static_cast< uint64_t >(id - m_Min);
+        return n / 64 < m_Bits.size() && ((m_Bits[n / 64] >> (n % 64)) & 1);
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * The conditions of a filter in the form that the kernels and the model lookups expect.
+*/
+struct Conditions
+{
+    // --------------------------------------------------------------------------------------------
+    double      mLo[3], mHi[3]; // The box and the height range combined into a single set of bounds
+    bool        mBounded; // Whether the positions have to be compared at all
+    ModelSet    mAllow, mDeny; // Models that are accepted and rejected
+    bool        mAllowed, mDenied; // Whether the models have to be looked up at all
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor.
+    */
+    explicit Conditions(const Filter & filter)
+        : mLo(), mHi(), mBounded(filter.mBox || filter.mRange)
+        , mAllow(filter.mAllow), mDeny(filter.mDeny)
+        , mAllowed(!filter.mAllow.empty()), mDenied(!filter.mDeny.empty())
+    {
+        for (unsigned a = 0; a < 3; ++a)
+        {
+            mLo[a] = filter.mBox ? filter.mMin[a] : -std::numeric_limits< double >::infinity();
+            mHi[a] = filter.mBox ? filter.mMax[a] : std::numeric_limits< double >::infinity();
+        }
+        if (filter.mRange)
+        {
+            mLo[2] = std::max(mLo[2], filter.mLow), mHi[2] = std::min(mHi[2], filter.mHigh);
+        }
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether the specified model is accepted.
+    */
+    bool Accepts(int32_t id) const
+    {
+        return (!mAllowed || mAllow.Has(id)) && (!mDenied || !mDeny.Has(id));
+    }
+};
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+void Columns::Assign(const Instances & inst_list)
+{
+    const size_t n = inst_list.size();
+    m_ID.resize(n), m_X.resize(n), m_Y.resize(n), m_Z.resize(n);
+    // Split every instance into the columns
+    for (size_t i = 0; i < n; ++i)
+    {
+        const Instance & inst = inst_list[i];
+        m_ID[i] = inst.mID, m_X[i] = inst.mX, m_Y[i] = inst.mY, m_Z[i] = inst.mZ;
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void Columns::Gather(const std::vector< uint32_t > & rows, Instances & out) const
+{
+    out.reserve(out.size() + rows.size());
+    // Join the columns of every selected row
+    for (uint32_t r : rows)
+    {
+        out.emplace_back(m_ID[r], m_X[r], m_Y[r], m_Z[r]);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void Select(const Columns & cols, const Filter & filter, std::vector< uint32_t > & rows)
+{
+    const size_t count = cols.Size();
+    const Conditions cond(filter);
+    // The columns being scanned
+    const int32_t * id = cols.ID();
+    const double * x = cols.Axis(0), * y = cols.Axis(1), * z = cols.Axis(2);
+    const Bounder bounds = Selected().mFn;
+    // Process 64 rows at a time
+    for (size_t base = 0; base < count; base += 64)
+    {
+        uint64_t mask = ~static_cast< uint64_t >(0);
+        // Compare the positions
+        if (cond.mBounded && count - base >= 64)
+        {
+            mask = bounds(x + base, y + base, z + base, cond.mLo, cond.mHi);
+        }
+        // The last rows don't fill a whole block
+        else if (cond.mBounded)
+        {
+            double bx[64] = {}, by[64] = {}, bz[64] = {};
+            std::copy(x + base, x + count, bx);
+            std::copy(y + base, y + count, by);
+            std::copy(z + base, z + count, bz);
+            mask = bounds(bx, by, bz, cond.mLo, cond.mHi);
+        }
+        // Ignore the rows past the end
+        if (count - base < 64)
+        {
+            mask &= (static_cast< uint64_t >(1) << (count - base)) - 1;
+        }
+        // Check the models of the rows that are still accepted
+        while (mask != 0)
+        {
+            const size_t r = base + LowestBit(mask);
+            mask &= mask - 1;
+            // Is the model accepted?
+            if (cond.Accepts(id[r]))
+            {
+                rows.push_back(static_cast< uint32_t >(r));
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void Apply(const Filter & filter, Instances & inst_list)
+{
+    // Is there anything to filter?
+    if (!filter.Enabled())
+    {
+        return;
+    }
+    const size_t count = inst_list.size();
+    const Conditions cond(filter);
+    const Bounder bounds = Selected().mFn;
+    // The positions of the current block, one column per axis
+    double x[64] = {}, y[64] = {}, z[64] = {};
+    // Where the next accepted instance goes
+    size_t kept = 0;
+    // Process 64 instances at a time
+    for (size_t base = 0; base < count; base += 64)
+    {
+        const size_t n = std::min(count - base, static_cast< size_t >(64));
+        uint64_t mask = ~static_cast< uint64_t >(0);
+        // Split the positions of this block into columns and compare them
+        if (cond.mBounded)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                const Instance & inst = inst_list[base + i];
+                x[i] = inst.mX, y[i] = inst.mY, z[i] = inst.mZ;
+            }
+            mask = bounds(x, y, z, cond.mLo, cond.mHi);
+        }
+        // Ignore the rows past the end, which still hold the previous block
+        if (n < 64)
+        {
+            mask &= (static_cast< uint64_t >(1) << n) - 1;
+        }
+        // Move the accepted instances down, which never overtakes the ones being read
+        while (mask != 0)
+        {
+            const size_t r = base + LowestBit(mask);
+            mask &= mask - 1;
+            // Is the model accepted?
+            if (cond.Accepts(inst_list[r].mID))
+            {
+                inst_list[kept++] = inst_list[r];
+            }
+        }
+    }
+    // Drop the instances that were not accepted
+    inst_list.erase(inst_list.begin() + static_cast< std::ptrdiff_t >(kept), inst_list.end());
+}
+
+// ------------------------------------------------------------------------------------------------
+const char * FilterKernel()
+{
+    return Selected().mName;
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,108 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Instances stored one column per field so that each field can be scanned contiguously.
+*/
+class Columns
+{
+private:
+
+    // --------------------------------------------------------------------------------------------
+    std::vector< int32_t >  m_ID; // Model identifiers
+    std::vector< double >   m_X, m_Y, m_Z; // Model positions
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Replace the contents with the specified instances.
+    */
+    void Assign(const Instances & inst_list);
+
+    /* --------------------------------------------------------------------------------------------
+     * Append the selected rows to the specified list of instances.
+    */
+    void Gather(const std::vector< uint32_t > & rows, Instances & out) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of rows.
+    */
+    size_t Size() const
+    {
+        return m_ID.size();
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the model identifiers.
+    */
+    const int32_t * ID() const
+    {
+        return m_ID.data();
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the positions along the specified axis.
+    */
+    const double * Axis(unsigned axis) const
+    {
+        return axis == 0 ? m_X.data() : (axis == 1 ? m_Y.data() : m_Z.data());
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Conditions that instances must meet before they are emitted. Conditions that are not enabled
+ * are ignored and the enabled ones must all be met.
+*/
+struct Filter
+{
+    // --------------------------------------------------------------------------------------------
+    std::vector< int >  mAllow; // Models that are accepted (empty accepts all)
+    std::vector< int >  mDeny; // Models that are rejected
+    // --------------------------------------------------------------------------------------------
+    bool                mBox = false; // Whether the instance must be inside a box
+    double              mMin[3] = {0.0, 0.0, 0.0}; // Lowest corner of the box
+    double              mMax[3] = {0.0, 0.0, 0.0}; // Highest corner of the box
+    // --------------------------------------------------------------------------------------------
+    bool                mRange = false; // Whether the height must be within a range
+    double              mLow = 0.0, mHigh = 0.0; // Accepted heights
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether any condition is enabled.
+    */
+    bool Enabled() const
+    {
+        return mBox || mRange || !mAllow.empty() || !mDeny.empty();
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Find the rows that meet the conditions, in their original order. Positions are compared with
+ * the widest vector kernel supported by the CPU.
+*/
+void Select(const Columns & cols, const Filter & filter, std::vector< uint32_t > & rows);
+
+/* ------------------------------------------------------------------------------------------------
+ * Remove the instances that do not meet the conditions, keeping the order of the others. The
+ * positions are split into columns one block at a time on the stack, so the list is filtered in
+ * place without ever being copied as a whole.
+*/
+void Apply(const Filter & filter, Instances & inst_list);
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the name of the kernel used to compare positions.
+*/
+const char * FilterKernel();
+
+} // Namespace:: VcMp
@@ -0,0 +1,319 @@
+// ------------------------------------------------------------------------------------------------
+#include "Diagnostics.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdio>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+const size_t CategoryCount = static_cast< size_t >(Category::Count);
+const size_t StageCount = static_cast< size_t >(Stage::Count);
+
+/* ------------------------------------------------------------------------------------------------
+ * Append the specified text as a quoted JSON string.
+*/
+void AppendQuoted(std::string & out, const std::string & str)
+{
+    out.push_back('"');
+    for (const char c : str)
+    {
+        switch (c)
+        {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+            {
+                // Escape the remaining control characters
+                if (static_cast< unsigned char >(c) < 0x20)
+                {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out.append(buf);
+                }
+                else
+                {
+                    out.push_back(c);
+                }
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Append a formatted number.
+*/
+void AppendNumber(std::string & out, const char * fmt, double value)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), fmt, value);
+    out.append(buf);
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+const char * CategoryName(Category cat)
+{
+    switch (cat)
+    {
+        case Category::File: return "file";
+        case Category::Tokens: return "tokens";
+        case Category::Values: return "values";
+        default: return "unknown";
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+const char * StageName(Stage stage)
+{
+    switch (stage)
+    {
+        case Stage::Read: return "read";
+        case Stage::Tokenize: return "tokenize";
+        case Stage::Convert: return "convert";
+        case Stage::Format: return "format";
+        case Stage::Display: return "display";
+        default: return "unknown";
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void Timings::Merge(const Timings & t)
+{
+    for (size_t i = 0; i < StageCount; ++i)
+    {
+        mSeconds[i] += t.mSeconds[i];
+    }
+    mElapsed += t.mElapsed;
+    mBytes += t.mBytes;
+    mInstances += t.mInstances;
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t Diagnostics::AddFile(const std::string & path)
+{
+    m_Files.push_back(path);
+    // Return the index of the file
+    return m_Files.size() - 1;
+}
+
+// ------------------------------------------------------------------------------------------------
+void Diagnostics::Add(size_t file, Category cat, const char * msg, int line)
+{
+    m_Problems.push_back(Problem{cat, file, line, msg});
+}
+
+// ------------------------------------------------------------------------------------------------
+Reporter Diagnostics::Bind(size_t file)
+{
+    return [this, file](Category cat, const char * msg, int line) {
+        Add(file, cat, msg, line);
+    };
+}
+
+// ------------------------------------------------------------------------------------------------
+void Diagnostics::Merge(const Diagnostics & d)
+{
+    // Files from the other collector are placed after ours
+    const size_t offset = m_Files.size();
+    m_Files.insert(m_Files.end(), d.m_Files.begin(), d.m_Files.end());
+    // Take the problems and point them to the relocated files
+    m_Problems.reserve(m_Problems.size() + d.m_Problems.size());
+    for (const auto & p : d.m_Problems)
+    {
+        m_Problems.push_back(p);
+        m_Problems.back().mFile += offset;
+    }
+    // Accumulate the timings
+    m_Timings.Merge(d.m_Timings);
+}
+
+// ------------------------------------------------------------------------------------------------
+void Diagnostics::Clear()
+{
+    m_Files.clear();
+    m_Problems.clear();
+    m_Timings = Timings();
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t Diagnostics::Count(Category cat) const
+{
+    size_t count = 0;
+    // Count the problems of this category
+    for (const auto & p : m_Problems)
+    {
+        count += (p.mCategory == cat);
+    }
+    // Return the count
+    return count;
+}
+
+// ------------------------------------------------------------------------------------------------
+std::string Diagnostics::Log() const
+{
+    std::string log;
+    // One line per problem
+    for (const auto & p : m_Problems)
+    {
+        log.append(m_Files[p.mFile]);
+        if (p.mLine > 0)
+        {
+            log.append(":").append(std::to_string(p.mLine));
+        }
+        log.append(": ").append(p.mMessage).append("\n");
+    }
+    // Return the log
+    return log;
+}
+
+// ------------------------------------------------------------------------------------------------
+std::string Diagnostics::Summary() const
+{
+    std::string out;
+    char buf[128];
+    // The amount of work that was done
+    std::snprintf(buf, sizeof(buf), "Files: %zu, bytes: %zu, instances: %zu\n",
+                    m_Files.size(), m_Timings.mBytes, m_Timings.mInstances);
+    out.append(buf);
+    // The problems of each category
+    std::snprintf(buf, sizeof(buf), "Problems: %zu (", m_Problems.size());
+    out.append(buf);
+    for (size_t i = 0; i < CategoryCount; ++i)
+    {
+        const Category cat = static_cast< Category >(i);
+        out.append(i ? ", " : "").append(CategoryName(cat)).append(": ")
+            .append(std::to_string(Count(cat)));
+    }
+    out.append(")\n");
+    // The time spent in each stage
+    out.append("Time (ms):");
+    for (size_t i = 0; i < StageCount; ++i)
+    {
+        out.append(i ? ", " : " ").append(StageName(static_cast< Stage >(i))).append(" ");
+        AppendNumber(out, "%.2f", m_Timings.mSeconds[i] * 1000.0);
+    }
+    if (m_Timings.mElapsed > 0.0)
+    {
+        out.append(", elapsed ");
+        AppendNumber(out, "%.2f", m_Timings.mElapsed * 1000.0);
+    }
+    out.append("\n");
+    // Is there anything else to show?
+    if (m_Problems.empty())
+    {
+        return out;
+    }
+    // Count the problems of each file
+    std::vector< size_t > per_file(m_Files.size(), 0);
+    for (const auto & p : m_Problems)
+    {
+        ++per_file[p.mFile];
+    }
+    // Show which files are bad
+    out.append("\nFiles with problems:\n");
+    for (size_t i = 0; i < m_Files.size(); ++i)
+    {
+        if (per_file[i] > 0)
+        {
+            out.append("  ").append(m_Files[i]).append(": ")
+                .append(std::to_string(per_file[i])).append("\n");
+        }
+    }
+    // Show the first problems
+    out.append("\nProblems:\n");
+    for (size_t i = 0; i < m_Problems.size() && i < MaxListed; ++i)
+    {
+        const Problem & p = m_Problems[i];
+        out.append("  ").append(m_Files[p.mFile]);
+        if (p.mLine > 0)
+        {
+            out.append(":").append(std::to_string(p.mLine));
+        }
+        out.append(": ").append(p.mMessage).append("\n");
+    }
+    // Mention how many were left out
+    if (m_Problems.size() > MaxListed)
+    {
+        out.append("  ... and ").append(std::to_string(m_Problems.size() - MaxListed))
+            .append(" more\n");
+    }
+    // Return the summary
+    return out;
+}
+
+// ------------------------------------------------------------------------------------------------
+std::string Diagnostics::JSON() const
+{
+    std::string out;
+    // Count the problems of each file
+    std::vector< size_t > per_file(m_Files.size(), 0), failed(m_Files.size(), 0);
+    for (const auto & p : m_Problems)
+    {
+        ++per_file[p.mFile];
+        failed[p.mFile] |= (p.mCategory == Category::File);
+    }
+    // The processed files
+    out.append("{\n  \"files\": [");
+    for (size_t i = 0; i < m_Files.size(); ++i)
+    {
+        out.append(i ? ",\n    {\"path\": " : "\n    {\"path\": ");
+        AppendQuoted(out, m_Files[i]);
+        out.append(", \"problems\": ").append(std::to_string(per_file[i]))
+            .append(", \"failed\": ").append(failed[i] ? "true}" : "false}");
+    }
+    out.append(m_Files.empty() ? "],\n" : "\n  ],\n");
+    // The problems of each category
+    out.append("  \"problems\": {\"total\": ").append(std::to_string(m_Problems.size()));
+    for (size_t i = 0; i < CategoryCount; ++i)
+    {
+        const Category cat = static_cast< Category >(i);
+        out.append(", \"").append(CategoryName(cat)).append("\": ")
+            .append(std::to_string(Count(cat)));
+    }
+    out.append("},\n");
+    // The first problems
+    out.append("  \"listed\": [");
+    for (size_t i = 0; i < m_Problems.size() && i < MaxListed; ++i)
+    {
+        const Problem & p = m_Problems[i];
+        out.append(i ? ",\n    {\"file\": " : "\n    {\"file\": ");
+        AppendQuoted(out, m_Files[p.mFile]);
+        out.append(", \"line\": ").append(std::to_string(p.mLine))
+            .append(", \"category\": \"").append(CategoryName(p.mCategory))
+            .append("\", \"message\": ");
+        AppendQuoted(out, p.mMessage);
+        out.append("}");
+    }
+    out.append(m_Problems.empty() ? "],\n" : "\n  ],\n");
+    // Mention how many were left out
+    out.append("  \"omitted\": ")
+        .append(std::to_string(m_Problems.size() > MaxListed ? m_Problems.size() - MaxListed : 0))
+        .append(",\n");
+    // The time spent in each stage
+    out.append("  \"seconds\": {");
+    for (size_t i = 0; i < StageCount; ++i)
+    {
+        out.append(i ? ", \"" : "\"").append(StageName(static_cast< Stage >(i))).append("\": ");
+        AppendNumber(out, "%.6f", m_Timings.mSeconds[i]);
+    }
+    out.append(", \"elapsed\": ");
+    AppendNumber(out, "%.6f", m_Timings.mElapsed);
+    out.append("},\n");
+    // The amount of work that was done
+    out.append("  \"bytes\": ").append(std::to_string(m_Timings.mBytes)).append(",\n")
+        .append("  \"instances\": ").append(std::to_string(m_Timings.mInstances)).append("\n}\n");
+    // Return the document
+    return out;
+}
+
+} // Namespace:: VcMp
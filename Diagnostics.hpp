@@ -0,0 +1,228 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * The kinds of problems that can be encountered while processing a file.
+*/
+enum class Category
+{
+    File = 0, // The file could not be processed at all
+    Tokens, // A line did not have the expected number of values
+    Values, // A value could not be converted
+    // --------------------------------------------------------------------------------------------
+    Count
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * The stages that the time is divided into.
+*/
+enum class Stage
+{
+    Read = 0, // Opening and mapping the input
+    Tokenize, // Locating the lines and values
+    Convert, // Converting the values of the instances
+    Format, // Generating the output
+    Display, // Handing the output to the window or the output file
+    // --------------------------------------------------------------------------------------------
+    Count
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the name of the specified category.
+*/
+const char * CategoryName(Category cat);
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the name of the specified stage.
+*/
+const char * StageName(Stage stage);
+
+/* ------------------------------------------------------------------------------------------------
+ * Receives the problems encountered while processing a file. The line is 0 when the problem
+ * does not belong to a specific line of the file.
+*/
+typedef std::function< void (Category cat, const char * msg, int line) > Reporter;
+
+/* ------------------------------------------------------------------------------------------------
+ * Measures the time between consecutive laps.
+*/
+class Stopwatch
+{
+    // --------------------------------------------------------------------------------------------
+    typedef std::chrono::steady_clock Clock;
+
+    // --------------------------------------------------------------------------------------------
+    Clock::time_point m_Start; // When the current lap started
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Default constructor. Starts the first lap.
+    */
+    Stopwatch()
+        : m_Start(Clock::now())
+    {
+        /* ... */
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the seconds since the current lap started and start another one.
+    */
+    double Lap()
+    {
+        const Clock::time_point now = Clock::now();
+        const std::chrono::duration< double > elapsed = now - m_Start;
+        m_Start = now;
+        // Return the duration of the lap
+        return elapsed.count();
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Time spent in each stage and the amount of work that was done. Stages performed by several
+ * workers at once accumulate the time of every worker.
+*/
+struct Timings
+{
+    // --------------------------------------------------------------------------------------------
+    double  mSeconds[static_cast< size_t >(Stage::Count)] = {}; // Time spent in each stage
+    double  mElapsed = 0.0; // Time from start to finish, when known
+    size_t  mBytes = 0; // Input bytes that were processed
+    size_t  mInstances = 0; // Instances that were extracted
+
+    /* --------------------------------------------------------------------------------------------
+     * Add time to the specified stage.
+    */
+    void Add(Stage stage, double seconds)
+    {
+        mSeconds[static_cast< size_t >(stage)] += seconds;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the time spent in the specified stage.
+    */
+    double Get(Stage stage) const
+    {
+        return mSeconds[static_cast< size_t >(stage)];
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Accumulate the specified timings into these.
+    */
+    void Merge(const Timings & t);
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Collects the problems and timings of a run without interrupting it. Each worker should fill
+ * its own collector and merge it into a common one once it is done.
+*/
+class Diagnostics
+{
+public:
+
+    // --------------------------------------------------------------------------------------------
+    static constexpr size_t MaxListed = 1000; // Problems listed by the summaries
+
+    /* --------------------------------------------------------------------------------------------
+     * A problem and where it was encountered.
+    */
+    struct Problem
+    {
+        // ----------------------------------------------------------------------------------------
+        Category    mCategory; // The kind of problem
+        size_t      mFile; // Index of the file it belongs to
+        int         mLine; // Line it belongs to (0 for the whole file)
+        std::string mMessage; // Description of the problem
+    };
+
+private:
+
+    // --------------------------------------------------------------------------------------------
+    std::vector< std::string >  m_Files; // Files that were processed
+    std::vector< Problem >      m_Problems; // Problems in the order they were reported
+    Timings                     m_Timings; // Time spent in each stage
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Register a file that is about to be processed and retrieve its index.
+    */
+    size_t AddFile(const std::string & path);
+
+    /* --------------------------------------------------------------------------------------------
+     * Record a problem with the specified file.
+    */
+    void Add(size_t file, Category cat, const char * msg, int line);
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve a reporter that records the problems of the specified file.
+    */
+    Reporter Bind(size_t file);
+
+    /* --------------------------------------------------------------------------------------------
+     * Append the files, problems and timings of another collector.
+    */
+    void Merge(const Diagnostics & d);
+
+    /* --------------------------------------------------------------------------------------------
+     * Forget everything that was collected.
+    */
+    void Clear();
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the timings.
+    */
+    Timings & Times()
+    {
+        return m_Timings;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the timings.
+    */
+    const Timings & Times() const
+    {
+        return m_Timings;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the recorded problems.
+    */
+    const std::vector< Problem > & Problems() const
+    {
+        return m_Problems;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of problems of the specified category.
+    */
+    size_t Count(Category cat) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve one line per problem, prefixed by the file and line it belongs to.
+    */
+    std::string Log() const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve a readable summary of the problems and timings.
+    */
+    std::string Summary() const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the problems and timings as a JSON document.
+    */
+    std::string JSON() const;
+};
+
+} // Namespace:: VcMp
@@ -0,0 +1,185 @@
+// ------------------------------------------------------------------------------------------------
+#include "Diff.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * What identifies an instance when comparing.
+*/
+struct Key
+{
+    // --------------------------------------------------------------------------------------------
+    int32_t mID; // Model identifier
+    int32_t mX, mY, mZ; // Quantized position
+
+    /* --------------------------------------------------------------------------------------------
+     * Equality comparison operator.
+    */
+    bool operator == (const Key & o) const
+    {
+        return mID == o.mID && mX == o.mX && mY == o.mY && mZ == o.mZ;
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the key of the specified instance.
+*/
+inline Key MakeKey(const Instance & inst)
+{
+    return Key{inst.mID, Quantize(inst.mX), Quantize(inst.mY), Quantize(inst.mZ)};
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Mix the fields of a key into a well distributed hash.
+*/
+inline uint64_t HashKey(const Key & k)
+{
+    uint64_t h = (static_cast< uint64_t >(static_cast< uint32_t >(k.mID)) << 32 |
+                    static_cast< uint32_t >(k.mX)) * 0x9E3779B97F4A7C15ULL;
+    h ^= (static_cast< uint64_t >(static_cast< uint32_t >(k.mY)) << 32 |
+                    static_cast< uint32_t >(k.mZ));
+    h *= 0xC2B2AE3D27D4EB4FULL;
+    // Bring the high bits down since the table only looks at the low ones
+    return h ^ (h >> 29);
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Open addressing table that counts how many times each key was seen. Sized once for the keys
+ * that will be inserted so it never has to grow.
+*/
+class KeyTable
+{
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * A key and how many times it was seen.
+    */
+    struct Slot
+    {
+        // ----------------------------------------------------------------------------------------
+        Key         mKey; // The key in this slot
+        uint32_t    mCount; // Unmatched occurrences of the key
+        bool        mUsed; // Whether the slot holds a key
+    };
+
+private:
+
+    // --------------------------------------------------------------------------------------------
+    std::vector< Slot > m_Slots; // The slots of the table
+    size_t              m_Mask; // Turns a hash into a slot index
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor. Makes room for the specified number of keys.
+    */
+    explicit KeyTable(size_t count)
+        : m_Slots(), m_Mask(0)
+    {
+        size_t capacity = 16;
+        // Keep the table at most half full so probes stay short
+        while (capacity < count * 2)
+        {
+            capacity <<= 1;
+        }
+        m_Slots.assign(capacity, Slot{Key{0, 0, 0, 0}, 0, false});
+        m_Mask = capacity - 1;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the slot of the specified key, claiming one if the key was not seen before.
+    */
+    Slot & Insert(const Key & key)
+    {
+        for (size_t i = HashKey(key) & m_Mask; ; i = (i + 1) & m_Mask)
+        {
+            Slot & slot = m_Slots[i];
+            // Is this a free slot?
+            if (!slot.mUsed)
+            {
+                slot.mKey = key;
+                slot.mUsed = true;
+                // The key is new
+                return slot;
+            }
+            // Is this the key we're looking for?
+            else if (slot.mKey == key)
+            {
+                return slot;
+            }
+        }
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the slot of the specified key. Null if the key was never seen.
+    */
+    Slot * Find(const Key & key)
+    {
+        for (size_t i = HashKey(key) & m_Mask; ; i = (i + 1) & m_Mask)
+        {
+            Slot & slot = m_Slots[i];
+            // Did we reach the end of the probe sequence?
+            if (!slot.mUsed)
+            {
+                return nullptr;
+            }
+            // Is this the key we're looking for?
+            else if (slot.mKey == key)
+            {
+                return &slot;
+            }
+        }
+    }
+};
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+void Compare(const Instances & before, const Instances & after,
+                Instances & added, Instances & removed)
+{
+    KeyTable table(before.size());
+    // Count the occurrences of every old instance
+    for (const auto & inst : before)
+    {
+        ++table.Insert(MakeKey(inst)).mCount;
+    }
+    // New instances either take one of the old occurrences or were added
+    for (const auto & inst : after)
+    {
+        KeyTable::Slot * slot = table.Find(MakeKey(inst));
+        // Is there an old occurrence left to match?
+        if (slot != nullptr && slot->mCount > 0)
+        {
+            --slot->mCount;
+        }
+        else
+        {
+            added.push_back(inst);
+        }
+    }
+    // Old occurrences that were not matched were removed
+    for (const auto & inst : before)
+    {
+        KeyTable::Slot * slot = table.Find(MakeKey(inst));
+        // Every old instance is in the table
+        if (slot->mCount > 0)
+        {
+            --slot->mCount;
+            removed.push_back(inst);
+        }
+    }
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,18 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Find the instances that were added and removed between two lists. Instances are the same when
+ * they have the same model and the same quantized position, which is the precision of the RAW
+ * and binary output. Duplicates are matched one to one and moved instances show up as removed
+ * from the old position and added at the new one. Both lists keep their original order.
+*/
+void Compare(const Instances & before, const Instances & after,
+                Instances & added, Instances & removed);
+
+} // Namespace:: VcMp
@@ -0,0 +1,51 @@
+// ------------------------------------------------------------------------------------------------
+#include "HideList.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstring>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+const char      HideMagic[8] = {'I', 'P', 'L', 'H', 'I', 'D', 'E', '\0'};
+const uint32_t  HideVersion = 1;
+
+// ------------------------------------------------------------------------------------------------
+static_assert(sizeof(HideHeader) == 16, "The hide list header must be packed");
+static_assert(sizeof(HideRecord) == 16, "The hide list records must be packed");
+
+// ------------------------------------------------------------------------------------------------
+HideList::HideList(const char * path)
+    : m_File(path), m_Records(nullptr), m_Count(0)
+{
+    // The records are used in place so this only works on little endian machines
+    const uint32_t probe = 1;
+    if (*reinterpret_cast< const unsigned char * >(&probe) != 1)
+    {
+        return;
+    }
+    // Is there enough data for the header?
+    if (!m_File.IsOpen() || m_File.Size() < sizeof(HideHeader))
+    {
+        return;
+    }
+    HideHeader header;
+    std::memcpy(&header, m_File.Data(), sizeof(header));
+    // Is this a hide list that we understand?
+    if (std::memcmp(header.mMagic, HideMagic, sizeof(HideMagic)) != 0 ||
+        header.mVersion != HideVersion)
+    {
+        return;
+    }
+    // Does the file hold every record?
+    if (m_File.Size() != sizeof(HideHeader) + header.mCount * sizeof(HideRecord))
+    {
+        return;
+    }
+    // The mapping is page aligned and the header keeps the records aligned
+    m_Records = reinterpret_cast< const HideRecord * >(m_File.Data() + sizeof(HideHeader));
+    m_Count = header.mCount;
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,99 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "MappedFile.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Layout of a binary hide list. Every field is a little endian 32-bit integer. The header is
+ * followed by `mCount` records with coordinates quantized the same way as the RAW output.
+*/
+struct HideHeader
+{
+    // --------------------------------------------------------------------------------------------
+    char        mMagic[8]; // File signature
+    uint32_t    mVersion; // File format version
+    uint32_t    mCount; // Number of records that follow
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * An instance in a binary hide list.
+*/
+struct HideRecord
+{
+    // --------------------------------------------------------------------------------------------
+    int32_t     mID; // Model identifier
+    int32_t     mX, mY, mZ; // Model position in tenths of a unit
+};
+
+// ------------------------------------------------------------------------------------------------
+extern const char       HideMagic[8]; // File signature
+extern const uint32_t   HideVersion; // File format version
+
+/* ------------------------------------------------------------------------------------------------
+ * Loads a binary hide list by mapping the file into memory. The records are used in place.
+*/
+class HideList
+{
+private:
+
+    // --------------------------------------------------------------------------------------------
+    MappedFile          m_File; // The mapped file
+    const HideRecord *  m_Records; // First record in the file
+    size_t              m_Count; // Number of records
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor. Maps and validates the specified file.
+    */
+    explicit HideList(const char * path);
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether the file was loaded and is a valid hide list.
+    */
+    bool IsValid() const
+    {
+        return m_Records != nullptr;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of records.
+    */
+    size_t Size() const
+    {
+        return m_Count;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the record at the specified position.
+    */
+    const HideRecord & operator [] (size_t i) const
+    {
+        return m_Records[i];
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the first record.
+    */
+    const HideRecord * begin() const
+    {
+        return m_Records;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve one past the last record.
+    */
+    const HideRecord * end() const
+    {
+        return m_Records + m_Count;
+    }
+};
+
+} // Namespace:: VcMp
@@ -0,0 +1,65 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <cmath>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * An instance in the IPL file.
+*/
+struct Instance
+{
+    // --------------------------------------------------------------------------------------------
+    int   mID; // Model IP
+    double mX, mY, mZ; // Model position
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor.
+    */
+    Instance(int id, double x,  double y,  double z)
+        : mID(id), mX(x), mY(y), mZ(z)
+    {
+        /* ... */
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy constructor.
+    */
+    Instance(const Instance & o) = default;
+
+    /* --------------------------------------------------------------------------------------------
+     * Move constructor.
+    */
+    Instance(Instance && o) = default;
+
+    /* --------------------------------------------------------------------------------------------
+     * Destructor.
+    */
+    ~Instance() = default;
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy assignment operator.
+    */
+    Instance & operator = (const Instance & o) = default;
+
+    /* --------------------------------------------------------------------------------------------
+     * Move assignment operator.
+    */
+    Instance & operator = (Instance && o) = default;
+};
+
+// ------------------------------------------------------------------------------------------------
+typedef std::vector< Instance > Instances; // Instance list
+
+/* ------------------------------------------------------------------------------------------------
+ * Adjust a coordinate to the integer form used by the RAW and binary output.
+*/
+inline int Quantize(double v)
+{
+    return static_cast< int >(std::floor(v * 10.0) + 0.5);
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,468 @@
+// ------------------------------------------------------------------------------------------------
+#include "InstanceCache.hpp"
+#include "MappedFile.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+
+// ------------------------------------------------------------------------------------------------
+#include <thread>
+#include <filesystem>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+namespace fs = std::filesystem;
+
+// ------------------------------------------------------------------------------------------------
+const char CacheMagic[8] = {'I', 'P', 'L', 'C', 'A', 'C', 'H', '\0'}; // File signature
+
+/* ------------------------------------------------------------------------------------------------
+ * Fixed portion at the start of a cache entry. Everything is stored in native byte order. The
+ * header is followed by the path of the file, the instances and the problems.
+*/
+struct CacheHeader
+{
+    // --------------------------------------------------------------------------------------------
+    char        mMagic[8]; // File signature
+    uint32_t    mVersion; // File format version
+    uint32_t    mPathLength; // Length of the path of the file
+    uint64_t    mSize; // Size of the file
+    int64_t     mTime; // Modification time of the file
+    uint64_t    mHash; // Hash of the contents
+    uint64_t    mCount; // Number of instances
+    uint64_t    mProblems; // Number of problems
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * An instance as stored in a cache entry.
+*/
+struct CacheRecord
+{
+    // --------------------------------------------------------------------------------------------
+    int32_t     mID; // Model identifier
+    int32_t     mReserved; // Padding
+    double      mX, mY, mZ; // Model position
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * A problem as stored in a cache entry. Followed by the message.
+*/
+struct CacheProblem
+{
+    // --------------------------------------------------------------------------------------------
+    int32_t     mCategory; // The kind of problem
+    int32_t     mLine; // Line it belongs to
+    uint32_t    mLength; // Length of the message
+    uint32_t    mReserved; // Padding
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Rotate the bits of a value to the left.
+*/
+inline uint64_t Rotate(uint64_t v, unsigned n)
+{
+    return (v << n) | (v >> (64 - n));
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Mix a word into a hash lane.
+*/
+inline uint64_t Mix(uint64_t lane, uint64_t word)
+{
+    return Rotate(lane ^ (word * 0x9E3779B97F4A7C15ull), 31) * 0xC2B2AE3D27D4EB4Full;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Write the specified values to a file.
+*/
+template < typename T > bool WriteAll(std::FILE * file, const T * data, size_t count)
+{
+    return std::fwrite(data, sizeof(T), count, file) == count;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Read the next value from mapped data, if there is enough of it left.
+*/
+template < typename T > bool ReadNext(const char *& data, const char * end, T & val)
+{
+    if (static_cast< size_t >(end - data) < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&val, data, sizeof(T));
+    data += sizeof(T);
+    // Value was read
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the size and modification time of the specified file.
+*/
+bool Stat(const std::string & path, uint64_t & size, int64_t & time)
+{
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    // Could we retrieve the size?
+    if (ec)
+    {
+        return false;
+    }
+    time = static_cast< int64_t >(fs::last_write_time(path, ec).time_since_epoch().count());
+    // Report whether we have both
+    return !ec;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the key that identifies the specified file, no matter how the path was written.
+*/
+std::string Key(const char * path)
+{
+    std::error_code ec;
+    const fs::path abs = fs::absolute(path, ec);
+    // Fall back to the path as written
+    return ec ? std::string(path) : abs.lexically_normal().string();
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+uint64_t HashContents(const char * data, size_t size)
+{
+    // Independent lanes let the words be mixed in parallel
+    uint64_t a = 0x60EA27EEADC0B5D6ull, b = 0x89B9A5D76DD8D9B1ull;
+    uint64_t c = 0x0B41D8A32DD2D4B7ull, d = 0x1A9F3C7E5D4B8A26ull ^ size;
+    const char * end = data + size;
+    // Mix 32 bytes at a time
+    for (; end - data >= 32; data += 32)
+    {
+        uint64_t w[4];
+        std::memcpy(w, data, sizeof(w));
+        a = Mix(a, w[0]), b = Mix(b, w[1]), c = Mix(c, w[2]), d = Mix(d, w[3]);
+    }
+    // Mix the remaining bytes
+    uint64_t h = Rotate(a, 1) + Rotate(b, 7) + Rotate(c, 12) + Rotate(d, 18);
+    for (; end - data >= 8; data += 8)
+    {
+        uint64_t w;
+        std::memcpy(&w, data, sizeof(w));
+        h = Mix(h, w);
+    }
+    for (; data < end; ++data)
+    {
+        h = Mix(h, static_cast< unsigned char >(*data));
+    }
+    // Spread every bit across the result
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    // Return the hash
+    return h;
+}
+
+// ------------------------------------------------------------------------------------------------
+InstanceCache::InstanceCache(const std::string & dir, bool keep)
+    : m_Dir(dir), m_Keep(keep), m_Mutex(), m_Entries(), m_Hits(0), m_Misses(0)
+{
+    // Make sure the directory exists
+    if (!m_Dir.empty())
+    {
+        std::error_code ec;
+        fs::create_directories(m_Dir, ec);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+bool InstanceCache::Extract(const char * iplpath, Instances & inst_list, const Reporter & report,
+                            const Progress & progress, Timings * timings)
+{
+    uint64_t size = 0;
+    int64_t time = 0;
+    // Is there anywhere to keep the entries? Can we tell whether the file changed?
+    if ((m_Dir.empty() && !m_Keep) || !iplpath || !Stat(iplpath, size, time))
+    {
+        return VcMp::Extract(iplpath, inst_list, report, progress, timings);
+    }
+    const std::string path = Key(iplpath);
+    // Measure how long it takes to find the entry
+    Stopwatch watch;
+    // The entry of this file, if any
+    EntryPtr entry;
+    {
+        std::lock_guard< std::mutex > guard(m_Mutex);
+        // Is there an entry in memory?
+        auto itr = m_Entries.find(path);
+        if (itr != m_Entries.end())
+        {
+            entry = itr->second;
+        }
+    }
+    // Is there an entry on disk?
+    if ((!entry || entry->mSize != size || entry->mTime != time) && !m_Dir.empty())
+    {
+        if (EntryPtr saved = Load(path))
+        {
+            entry = std::move(saved);
+        }
+    }
+    // Whether the entry has to be remembered and saved again
+    bool store = false, save = false;
+    // Whether the file had to be parsed
+    bool parsed = false;
+    // Did the file change since the entry was created?
+    if (!entry || entry->mSize != size || entry->mTime != time)
+    {
+        MappedFile file(iplpath);
+        // See if the file could be opened
+        if (!file.IsOpen())
+        {
+            report(Category::File, "Unable to open the selected file", 0);
+            // We're done here
+            return false;
+        }
+        const uint64_t hash = HashContents(file.Data(), file.Size());
+        // Are the contents still the same?
+        if (entry && entry->mSize == file.Size() && entry->mHash == hash)
+        {
+            auto touched = std::make_shared< Entry >(*entry);
+            touched->mTime = time;
+            entry = std::move(touched);
+        }
+        // The file has to be parsed
+        else
+        {
+            auto fresh = std::make_shared< Entry >();
+            fresh->mSize = file.Size(), fresh->mTime = time, fresh->mHash = hash;
+            // Keep the problems so they can be reported every time the entry is used
+            const Reporter keep = [&fresh](Category cat, const char * msg, int line) {
+                fresh->mProblems.push_back(Problem{cat, line, msg});
+            };
+            // Hashing counts as reading
+            if (timings)
+            {
+                timings->Add(Stage::Read, watch.Lap());
+            }
+            // Parse the contents that are already mapped. A cancelled parse may have produced
+            // part of the instances, so it must never be kept. Without any instances, ask once
+            // more whether we should continue to tell a cancelled parse from an empty file
+            if (!ExtractBuffer(file.Data(), file.Size(), fresh->mInstances, keep, progress,
+                                timings) && (!fresh->mInstances.empty() ||
+                                            (progress && !progress(file.Size(), file.Size()))))
+            {
+                return false; // Cancelled!
+            }
+            entry = std::move(fresh);
+            parsed = true;
+        }
+        store = save = true;
+    }
+    // The entry on disk was used
+    else if (m_Keep)
+    {
+        std::lock_guard< std::mutex > guard(m_Mutex);
+        auto itr = m_Entries.find(path);
+        // Keep it in memory unless it already is
+        store = (itr == m_Entries.end() || itr->second != entry);
+    }
+    // Remember the entry, if necessary
+    if (store)
+    {
+        Store(path, entry, save);
+    }
+    // Count the hit or the miss
+    {
+        std::lock_guard< std::mutex > guard(m_Mutex);
+        ++(parsed ? m_Misses : m_Hits);
+    }
+    // Report the problems found when the file was parsed
+    for (const auto & p : entry->mProblems)
+    {
+        report(p.mCategory, p.mMessage.c_str(), p.mLine);
+    }
+    // Hand over the instances
+    inst_list.insert(inst_list.end(), entry->mInstances.begin(), entry->mInstances.end());
+    // Record the timings of entries that were not parsed
+    if (timings && !parsed)
+    {
+        timings->Add(Stage::Read, watch.Lap());
+        timings->mBytes += entry->mSize;
+        timings->mInstances += entry->mInstances.size();
+    }
+    // Return whether this file gave the caller anything, like Extract() does
+    return !entry->mInstances.empty();
+}
+
+// ------------------------------------------------------------------------------------------------
+void InstanceCache::Clear()
+{
+    std::lock_guard< std::mutex > guard(m_Mutex);
+    m_Entries.clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t InstanceCache::Hits()
+{
+    std::lock_guard< std::mutex > guard(m_Mutex);
+    return m_Hits;
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t InstanceCache::Misses()
+{
+    std::lock_guard< std::mutex > guard(m_Mutex);
+    return m_Misses;
+}
+
+// ------------------------------------------------------------------------------------------------
+std::string InstanceCache::EntryPath(const std::string & path) const
+{
+    char name[32];
+    // Name the entry after the hash of the path
+    std::snprintf(name, sizeof(name), "%016llx.iplc",
+                    static_cast< unsigned long long >(HashContents(path.data(), path.size())));
+    // Return the full path
+    return (fs::path(m_Dir) / name).string();
+}
+
+// ------------------------------------------------------------------------------------------------
+InstanceCache::EntryPtr InstanceCache::Load(const std::string & path) const
+{
+    MappedFile file(EntryPath(path).c_str());
+    // Was there anything saved?
+    if (!file.IsOpen())
+    {
+        return EntryPtr();
+    }
+    const char * data = file.Data(), * end = file.Data() + file.Size();
+    CacheHeader header;
+    // Is this an entry that we understand?
+    if (!ReadNext(data, end, header) ||
+        std::memcmp(header.mMagic, CacheMagic, sizeof(CacheMagic)) != 0 ||
+        header.mVersion != Version || header.mPathLength != path.size() ||
+        static_cast< size_t >(end - data) < path.size() ||
+        path.compare(0, path.size(), data, header.mPathLength) != 0)
+    {
+        return EntryPtr();
+    }
+    data += header.mPathLength;
+    // Are all the instances there?
+    if (header.mCount > static_cast< size_t >(end - data) / sizeof(CacheRecord))
+    {
+        return EntryPtr();
+    }
+    // Load the parsed contents
+    auto entry = std::make_shared< Entry >();
+    entry->mSize = header.mSize, entry->mTime = header.mTime, entry->mHash = header.mHash;
+    // Load the instances
+    entry->mInstances.reserve(header.mCount);
+    for (uint64_t i = 0; i < header.mCount; ++i)
+    {
+        CacheRecord r;
+        ReadNext(data, end, r);
+        entry->mInstances.emplace_back(r.mID, r.mX, r.mY, r.mZ);
+    }
+    // Load the problems
+    for (uint64_t i = 0; i < header.mProblems; ++i)
+    {
+        CacheProblem p;
+        // Is the problem complete?
+        if (!ReadNext(data, end, p) || static_cast< size_t >(end - data) < p.mLength)
+        {
+            return EntryPtr();
+        }
+        entry->mProblems.push_back(Problem{static_cast< Category >(p.mCategory), p.mLine,
+                                            std::string(data, p.mLength)});
+        data += p.mLength;
+    }
+    // Return the entry only if nothing is left over
+    return data == end ? entry : EntryPtr();
+}
+
+// ------------------------------------------------------------------------------------------------
+bool InstanceCache::Save(const std::string & path, const Entry & entry) const
+{
+    const std::string dest = EntryPath(path);
+    // Write to a temporary file first so that readers never see a partial entry
+    const std::string temp = dest + "." +
+                    std::to_string(std::hash< std::thread::id >()(std::this_thread::get_id()));
+    // Attempt to create the file
+    std::FILE * file = std::fopen(temp.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    // Prepare the header
+    CacheHeader header;
+    std::memcpy(header.mMagic, CacheMagic, sizeof(CacheMagic));
+    header.mVersion = Version;
+    header.mPathLength = static_cast< uint32_t >(path.size());
+    header.mSize = entry.mSize, header.mTime = entry.mTime, header.mHash = entry.mHash;
+    header.mCount = entry.mInstances.size();
+    header.mProblems = entry.mProblems.size();
+    // Prepare the instances
+    std::vector< CacheRecord > records(entry.mInstances.size());
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        const Instance & inst = entry.mInstances[i];
+        records[i] = {inst.mID, 0, inst.mX, inst.mY, inst.mZ};
+    }
+    // Write everything
+    bool ok = WriteAll(file, &header, 1) && WriteAll(file, path.data(), path.size()) &&
+                WriteAll(file, records.data(), records.size());
+    for (const auto & p : entry.mProblems)
+    {
+        const CacheProblem cp = {static_cast< int32_t >(p.mCategory), p.mLine,
+                                    static_cast< uint32_t >(p.mMessage.size()), 0};
+        ok = ok && WriteAll(file, &cp, 1) &&
+                    WriteAll(file, p.mMessage.data(), p.mMessage.size());
+    }
+    // Make sure everything reached the file
+    ok = (std::fclose(file) == 0) && ok;
+    // Replace the previous entry in one go
+    std::error_code ec;
+    if (ok)
+    {
+        fs::rename(temp, dest, ec);
+    }
+    // Don't leave anything behind on failure
+    if (!ok || ec)
+    {
+        fs::remove(temp, ec);
+        return false;
+    }
+    // The entry was saved
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+void InstanceCache::Store(const std::string & path, const EntryPtr & entry, bool save)
+{
+    // Files that could not be processed are not worth remembering
+    for (const auto & p : entry->mProblems)
+    {
+        if (p.mCategory == Category::File)
+        {
+            return;
+        }
+    }
+    // Keep it in memory
+    if (m_Keep)
+    {
+        std::lock_guard< std::mutex > guard(m_Mutex);
+        m_Entries[path] = entry;
+    }
+    // Keep it on disk
+    if (save && !m_Dir.empty())
+    {
+        Save(path, *entry);
+    }
+}
+
+} // Namespace:: VcMp
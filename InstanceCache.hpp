@@ -0,0 +1,139 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Parser.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Compute a fast, non-cryptographic hash of the specified contents.
+*/
+uint64_t HashContents(const char * data, size_t size);
+
+/* ------------------------------------------------------------------------------------------------
+ * Keeps the instances parsed from each file so that unchanged files are not parsed again. Entries
+ * are kept in memory and, optionally, in a directory so they survive restarts. An entry is used
+ * straight away when the size and modification time of the file did not change, and otherwise
+ * when the contents still have the same hash. The problems found while parsing are kept with the
+ * entry and reported again every time it is used. Safe to use from several workers at once.
+*/
+class InstanceCache
+{
+public:
+
+    // --------------------------------------------------------------------------------------------
+    static const uint32_t Version = 1; // Format of the entries stored on disk
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * A problem found while parsing a file.
+    */
+    struct Problem
+    {
+        // ----------------------------------------------------------------------------------------
+        Category    mCategory; // The kind of problem
+        int         mLine; // Line it belongs to
+        std::string mMessage; // Description of the problem
+    };
+
+    /* --------------------------------------------------------------------------------------------
+     * The parsed contents of a file.
+    */
+    struct Entry
+    {
+        // ----------------------------------------------------------------------------------------
+        uint64_t                mSize = 0; // Size of the file
+        int64_t                 mTime = 0; // Modification time of the file
+        uint64_t                mHash = 0; // Hash of the contents
+        Instances               mInstances; // Instances found in the file
+        std::vector< Problem >  mProblems; // Problems found in the file
+    };
+
+    // --------------------------------------------------------------------------------------------
+    typedef std::shared_ptr< const Entry > EntryPtr;
+
+    // --------------------------------------------------------------------------------------------
+    std::string                                 m_Dir; // Where entries are stored (empty for none)
+    bool                                        m_Keep; // Whether entries are kept in memory
+    std::mutex                                  m_Mutex; // Guards the entries and counters
+    std::unordered_map< std::string, EntryPtr > m_Entries; // Entries kept in memory by path
+    size_t                                      m_Hits; // Files that did not have to be parsed
+    size_t                                      m_Misses; // Files that had to be parsed
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor. Entries are stored in the specified directory, unless empty, and kept in
+     * memory, if requested. The directory is created when missing.
+    */
+    explicit InstanceCache(const std::string & dir = std::string(), bool keep = true);
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy constructor. (disabled)
+    */
+    InstanceCache(const InstanceCache &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy assignment operator. (disabled)
+    */
+    InstanceCache & operator = (const InstanceCache &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Append the instances of the specified IPL file to the list, parsing it only when needed.
+     * Behaves like Extract otherwise.
+    */
+    bool Extract(const char * iplpath, Instances & inst_list, const Reporter & report,
+                    const Progress & progress = Progress(), Timings * timings = nullptr);
+
+    /* --------------------------------------------------------------------------------------------
+     * Forget the entries kept in memory. Entries on disk are left alone.
+    */
+    void Clear();
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of files that did not have to be parsed.
+    */
+    size_t Hits();
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of files that had to be parsed.
+    */
+    size_t Misses();
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the path of the file that stores the entry of the specified file.
+    */
+    std::string EntryPath(const std::string & path) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Load the entry of the specified file from disk.
+    */
+    EntryPtr Load(const std::string & path) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Store the entry of the specified file on disk.
+    */
+    bool Save(const std::string & path, const Entry & entry) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Remember the entry of the specified file, in memory and on disk as configured.
+    */
+    void Store(const std::string & path, const EntryPtr & entry, bool save);
+};
+
+} // Namespace:: VcMp
@@ -0,0 +1,261 @@
+// ------------------------------------------------------------------------------------------------
+#include "IplHide.h"
+#include "Parser.hpp"
+#include "Builder.hpp"
+#include "Columns.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <new>
+#include <type_traits>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+static_assert(std::is_trivially_copyable< Instance >::value, "Instances are copied as bytes");
+static_assert(sizeof(Instance) == sizeof(iplhide_instance) &&
+                offsetof(Instance, mX) == offsetof(iplhide_instance, x) &&
+                offsetof(Instance, mZ) == offsetof(iplhide_instance, z),
+                "Instances must have the same layout on both sides");
+static_assert(static_cast< int >(Format::GRAW) == IPLHIDE_FORMAT_GRAW &&
+                static_cast< int >(Format::BIN) == IPLHIDE_FORMAT_BIN,
+                "Formats must have the same values on both sides");
+static_assert(static_cast< int >(Category::Values) == IPLHIDE_PROBLEM_VALUES,
+                "Categories must have the same values on both sides");
+
+/* ------------------------------------------------------------------------------------------------
+ * Allocate a block from the specified allocator, or from malloc when there is none.
+*/
+void * Allocate(const iplhide_allocator * alloc, size_t size)
+{
+    return alloc ? alloc->alloc(alloc->user, size) : std::malloc(size);
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the instances through the specified routine and hand them over in a single buffer.
+*/
+template < typename F > iplhide_status Parse(F && extract, const iplhide_allocator * alloc,
+                                                iplhide_reporter report, void * user,
+                                                iplhide_instance ** list, size_t * count)
+{
+    // Is there somewhere to put the instances?
+    if (list == nullptr || count == nullptr || (alloc && (!alloc->alloc || !alloc->release)))
+    {
+        return IPLHIDE_ERROR_ARGUMENT;
+    }
+    *list = nullptr, *count = 0;
+    // Whether the file itself could not be read
+    bool unreadable = false;
+    try
+    {
+        Instances inst_list;
+        // Pass the problems along to the caller
+        extract(inst_list, [&](Category cat, const char * msg, int line) {
+            unreadable |= (cat == Category::File);
+            // Does the caller care?
+            if (report)
+            {
+                report(user, static_cast< iplhide_category >(cat), line, msg);
+            }
+        });
+        // Is there anything to hand over?
+        if (unreadable || inst_list.empty())
+        {
+            return unreadable ? IPLHIDE_ERROR_FILE : IPLHIDE_OK;
+        }
+        const size_t size = inst_list.size() * sizeof(iplhide_instance);
+        // Allocate the buffer from the caller
+        void * data = Allocate(alloc, size);
+        if (data == nullptr)
+        {
+            return IPLHIDE_ERROR_MEMORY;
+        }
+        // The layouts are the same
+        std::memcpy(data, inst_list.data(), size);
+        *list = static_cast< iplhide_instance * >(data);
+        *count = inst_list.size();
+    }
+    catch (const std::bad_alloc &)
+    {
+        return IPLHIDE_ERROR_MEMORY;
+    }
+    // The instances were handed over
+    return IPLHIDE_OK;
+}
+
+} // Namespace:: (anonymous)
+
+} // Namespace:: VcMp
+
+// ------------------------------------------------------------------------------------------------
+using namespace VcMp;
+
+// ------------------------------------------------------------------------------------------------
+unsigned iplhide_abi_version(void)
+{
+    return IPLHIDE_ABI_VERSION;
+}
+
+// ------------------------------------------------------------------------------------------------
+iplhide_status iplhide_format_from_name(const char * name, iplhide_format * fmt)
+{
+    Format f;
+    // Is this a known format?
+    if (name == nullptr || fmt == nullptr || !FormatFromName(name, f))
+    {
+        return IPLHIDE_ERROR_ARGUMENT;
+    }
+    *fmt = static_cast< iplhide_format >(f);
+    // The format was found
+    return IPLHIDE_OK;
+}
+
+// ------------------------------------------------------------------------------------------------
+iplhide_status iplhide_parse_file(const char * path, const iplhide_allocator * alloc,
+                                    iplhide_reporter report, void * user,
+                                    iplhide_instance ** list, size_t * count)
+{
+    // Is there a file to read?
+    if (path == nullptr)
+    {
+        return IPLHIDE_ERROR_ARGUMENT;
+    }
+    return Parse([path](Instances & inst_list, const Reporter & rep) {
+        Extract(path, inst_list, rep);
+    }, alloc, report, user, list, count);
+}
+
+// ------------------------------------------------------------------------------------------------
+iplhide_status iplhide_parse_buffer(const char * data, size_t size,
+                                    const iplhide_allocator * alloc,
+                                    iplhide_reporter report, void * user,
+                                    iplhide_instance ** list, size_t * count)
+{
+    // Is there data to read?
+    if (data == nullptr && size > 0)
+    {
+        return IPLHIDE_ERROR_ARGUMENT;
+    }
+    return Parse([data, size](Instances & inst_list, const Reporter & rep) {
+        ExtractBuffer(data, size, inst_list, rep);
+    }, alloc, report, user, list, count);
+}
+
+// ------------------------------------------------------------------------------------------------
+iplhide_status iplhide_filter_instances(const iplhide_filter * filter,
+                                        iplhide_instance * list, size_t * count)
+{
+    // Is there anything to filter?
+    if (filter == nullptr || count == nullptr || (list == nullptr && *count > 0))
+    {
+        return IPLHIDE_ERROR_ARGUMENT;
+    }
+    try
+    {
+        Filter f;
+        // Translate the conditions
+        if (filter->allow != nullptr)
+        {
+            f.mAllow.assign(filter->allow, filter->allow + filter->allow_count);
+        }
+        if (filter->deny != nullptr)
+        {
+            f.mDeny.assign(filter->deny, filter->deny + filter->deny_count);
+        }
+        f.mBox = (filter->box != 0);
+        std::memcpy(f.mMin, filter->min, sizeof(f.mMin));
+        std::memcpy(f.mMax, filter->max, sizeof(f.mMax));
+        f.mRange = (filter->range != 0);
+        f.mLow = filter->low, f.mHigh = filter->high;
+        // Is there anything to check?
+        if (!f.Enabled() || *count == 0)
+        {
+            return IPLHIDE_OK;
+        }
+        // The filter works on instance lists
+        Instances inst_list(reinterpret_cast< const Instance * >(list),
+                            reinterpret_cast< const Instance * >(list) + *count);
+        Apply(f, inst_list);
+        // Move the kept instances to the front
+        std::memcpy(list, inst_list.data(), inst_list.size() * sizeof(iplhide_instance));
+        *count = inst_list.size();
+    }
+    catch (const std::bad_alloc &)
+    {
+        return IPLHIDE_ERROR_MEMORY;
+    }
+    // The instances were filtered
+    return IPLHIDE_OK;
+}
+
+// ------------------------------------------------------------------------------------------------
+iplhide_status iplhide_emit(const iplhide_instance * list, size_t count,
+                            iplhide_format fmt, const char * func,
+                            const iplhide_allocator * alloc, char ** output, size_t * size)
+{
+    // Is there somewhere to put the output?
+    if ((list == nullptr && count > 0) || output == nullptr || size == nullptr ||
+        fmt < IPLHIDE_FORMAT_XML || fmt > IPLHIDE_FORMAT_GRAW ||
+        (alloc && (!alloc->alloc || !alloc->release)))
+    {
+        return IPLHIDE_ERROR_ARGUMENT;
+    }
+    *output = nullptr, *size = 0;
+    try
+    {
+        const Instances inst_list(reinterpret_cast< const Instance * >(list),
+                                    reinterpret_cast< const Instance * >(list) + count);
+        Writer out;
+        // Generate the output in memory
+        if (!Build(static_cast< Format >(fmt), inst_list, func ? func : "HideMapObject", out))
+        {
+            return IPLHIDE_ERROR_OUTPUT;
+        }
+        // Is there anything to hand over?
+        else if (out.Size() == 0)
+        {
+            return IPLHIDE_OK;
+        }
+        // Allocate the buffer from the caller
+        char * data = static_cast< char * >(Allocate(alloc, out.Size()));
+        if (data == nullptr)
+        {
+            return IPLHIDE_ERROR_MEMORY;
+        }
+        out.CopyTo(data);
+        *output = data;
+        *size = out.Size();
+    }
+    catch (const std::bad_alloc &)
+    {
+        return IPLHIDE_ERROR_MEMORY;
+    }
+    // The output was handed over
+    return IPLHIDE_OK;
+}
+
+// ------------------------------------------------------------------------------------------------
+void iplhide_release(const iplhide_allocator * alloc, void * ptr, size_t size)
+{
+    // Is there anything to release?
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    else if (alloc)
+    {
+        alloc->release(alloc->user, ptr, size);
+    }
+    else
+    {
+        std::free(ptr);
+    }
+}
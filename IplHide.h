@@ -0,0 +1,166 @@
+#pragma once
+
+/* ------------------------------------------------------------------------------------------------
+ * C interface to the parser, the filters and the output formats, meant for plugins and other
+ * programs that want to process IPL files in-process. Every buffer handed to the caller comes
+ * from the allocator the caller specifies, or from malloc when none is specified, and must be
+ * released the same way. No exceptions or C++ types cross this interface.
+*/
+
+// ------------------------------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------------------------------------------------
+#if defined(_WIN32) && defined(IPLHIDE_SHARED)
+    #ifdef IPLHIDE_BUILD
+        #define IPLHIDE_API __declspec(dllexport)
+    #else
+        #define IPLHIDE_API __declspec(dllimport)
+    #endif
+#elif defined(__GNUC__)
+    #define IPLHIDE_API __attribute__((visibility("default")))
+#else
+    #define IPLHIDE_API
+#endif
+
+// ------------------------------------------------------------------------------------------------
+#define IPLHIDE_ABI_VERSION 2 // Changes whenever the interface below changes
+
+// ------------------------------------------------------------------------------------------------
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ * Outcome of the calls.
+*/
+typedef enum iplhide_status
+{
+    IPLHIDE_OK = 0, // Everything went fine
+    IPLHIDE_ERROR_ARGUMENT, // An argument was not valid
+    IPLHIDE_ERROR_FILE, // The file could not be read
+    IPLHIDE_ERROR_MEMORY, // Memory could not be allocated
+    IPLHIDE_ERROR_OUTPUT // The output could not be generated
+} iplhide_status;
+
+/* ------------------------------------------------------------------------------------------------
+ * The kind of output that can be generated. Same as the format names of the command line.
+*/
+typedef enum iplhide_format
+{
+    IPLHIDE_FORMAT_XML = 0, // XML map rules
+    IPLHIDE_FORMAT_NUT, // Script function calls with unmodified coordinates
+    IPLHIDE_FORMAT_RAW, // Script function calls with adjusted coordinates
+    IPLHIDE_FORMAT_BIN, // Binary hide list with adjusted coordinates
+    IPLHIDE_FORMAT_TNUT, // Script tables grouped by model with unmodified coordinates
+    IPLHIDE_FORMAT_TRAW, // Script tables grouped by model with adjusted coordinates
+    IPLHIDE_FORMAT_DELTA, // Script tables grouped by model with delta encoded coordinates
+    IPLHIDE_FORMAT_GNUT, // Script tables grouped by map cell with unmodified coordinates
+    IPLHIDE_FORMAT_GRAW // Script tables grouped by map cell with adjusted coordinates
+} iplhide_format;
+
+/* ------------------------------------------------------------------------------------------------
+ * The kind of problem found while parsing.
+*/
+typedef enum iplhide_category
+{
+    IPLHIDE_PROBLEM_FILE = 0, // The file could not be read
+    IPLHIDE_PROBLEM_TOKENS, // A line has the wrong number of tokens
+    IPLHIDE_PROBLEM_VALUES // A value could not be converted
+} iplhide_category;
+
+/* ------------------------------------------------------------------------------------------------
+ * An instance in an IPL file.
+*/
+typedef struct iplhide_instance
+{
+    int32_t id; // Model identifier
+    double  x, y, z; // Model position
+} iplhide_instance;
+
+/* ------------------------------------------------------------------------------------------------
+ * Memory routines used for every buffer handed to the caller. The size of the block is passed
+ * back when releasing it, for allocators that need it.
+*/
+typedef struct iplhide_allocator
+{
+    void *  (*alloc)(void * user, size_t size); // Allocate a block, null on failure
+    void    (*release)(void * user, void * ptr, size_t size); // Release a block
+    void *  user; // Passed to both routines
+} iplhide_allocator;
+
+/* ------------------------------------------------------------------------------------------------
+ * Receives the problems found while parsing. The line is 0 for problems with the whole file.
+*/
+typedef void (*iplhide_reporter)(void * user, iplhide_category cat, int line, const char * msg);
+
+/* ------------------------------------------------------------------------------------------------
+ * Conditions that instances must meet to be kept. Conditions that are not enabled are ignored
+ * and the enabled ones must all be met.
+*/
+typedef struct iplhide_filter
+{
+    const int32_t * allow; // Models that are accepted (null or empty accepts all)
+    size_t          allow_count; // Number of accepted models
+    const int32_t * deny; // Models that are rejected
+    size_t          deny_count; // Number of rejected models
+    int             box; // Whether the instance must be inside a box
+    double          min[3], max[3]; // Corners of the box
+    int             range; // Whether the height must be within a range
+    double          low, high; // Accepted heights
+} iplhide_filter;
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the version of the interface the library was built with. Compare with
+ * IPLHIDE_ABI_VERSION before using anything else.
+*/
+IPLHIDE_API unsigned iplhide_abi_version(void);
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the format identified by the specified name. (case insensitive)
+*/
+IPLHIDE_API iplhide_status iplhide_format_from_name(const char * name, iplhide_format * fmt);
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the instances from the specified IPL file into a buffer from the allocator. Problems
+ * with individual lines are reported and skipped. Nothing is allocated when no instance is found.
+*/
+IPLHIDE_API iplhide_status iplhide_parse_file(const char * path, const iplhide_allocator * alloc,
+                                                iplhide_reporter report, void * user,
+                                                iplhide_instance ** list, size_t * count);
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the instances from IPL data that is already in memory. Same as iplhide_parse_file().
+*/
+IPLHIDE_API iplhide_status iplhide_parse_buffer(const char * data, size_t size,
+                                                const iplhide_allocator * alloc,
+                                                iplhide_reporter report, void * user,
+                                                iplhide_instance ** list, size_t * count);
+
+/* ------------------------------------------------------------------------------------------------
+ * Remove the instances that don't meet the conditions. The kept instances are moved to the
+ * front of the list in their original order and their number replaces the count. The list stays
+ * the same block, so it's still released with the size it was handed out with.
+*/
+IPLHIDE_API iplhide_status iplhide_filter_instances(const iplhide_filter * filter,
+                                                    iplhide_instance * list, size_t * count);
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate the output of the specified format into a buffer from the allocator. The function
+ * name is used by script formats. Grids use map cells of 250 units. Text output is not null
+ * terminated.
+*/
+IPLHIDE_API iplhide_status iplhide_emit(const iplhide_instance * list, size_t count,
+                                        iplhide_format fmt, const char * func,
+                                        const iplhide_allocator * alloc,
+                                        char ** output, size_t * size);
+
+/* ------------------------------------------------------------------------------------------------
+ * Release a buffer handed out by this library, using the same allocator that produced it.
+*/
+IPLHIDE_API void iplhide_release(const iplhide_allocator * alloc, void * ptr, size_t size);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
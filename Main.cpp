@@ -1,18 +1,20 @@
 // ------------------------------------------------------------------------------------------------
-#include <cmath>
-#include <cstdio>
-#include <cctype>
+#include "Batch.hpp"
+#include "Parser.hpp"
+#include "Builder.hpp"
+#include "Template.hpp"
+#include "OutputView.hpp"
+#include "InstanceCache.hpp"
+
+// ------------------------------------------------------------------------------------------------
 #include <cstdlib>
-#include <cstring>
 
 // ------------------------------------------------------------------------------------------------
 #include <string>
 #include <vector>
+#include <atomic>
+#include <thread>
 #include <memory>
-#include <locale>
-#include <sstream>
-#include <fstream>
-#include <iterator>
 
 // ------------------------------------------------------------------------------------------------
 #include <FL/Fl_Input.H>
@@ -24,6 +26,7 @@
 #include <FL/Fl_Light_Button.H>
 #include <FL/Fl_Double_Window.H>
 #include <FL/Fl_Text_Display.H>
+#include <FL/Fl_Progress.H>
 
 // ------------------------------------------------------------------------------------------------
 namespace VcMp {
@@ -49,8 +52,7 @@ protected:
     Fl_File_Icon       *m_InputIcon; // Icon for the input show button
 
     // --------------------------------------------------------------------------------------------
-    Fl_Text_Display    *m_OutputBox; // Buffer display
-    Fl_Text_Buffer     *m_OutputBuffer; // Output buffer
+    OutputView         *m_OutputView; // Output display
 
     // --------------------------------------------------------------------------------------------
     Fl_Button          *m_BuildXML; // Generate XML data
@@ -59,87 +61,33 @@ protected:
 
     // --------------------------------------------------------------------------------------------
     Fl_Input           *m_FuncName; // Function name input
-
-private:
-
-    /* --------------------------------------------------------------------------------------------
-     * An instance in the IPL file.
-    */
-    struct Instance
-    {
-        // ----------------------------------------------------------------------------------------
-        int   mID; // Model IP
-        double mX, mY, mZ; // Model position
-
-        /* ----------------------------------------------------------------------------------------
-         * Base constructor.
-        */
-        Instance(int id, double x,  double y,  double z)
-            : mID(id), mX(x), mY(y), mZ(z)
-        {
-            /* ... */
-        }
-
-        /* ----------------------------------------------------------------------------------------
-         * Copy constructor.
-        */
-        Instance(const Instance & o) = default;
-
-        /* ----------------------------------------------------------------------------------------
-         * Move constructor.
-        */
-        Instance(Instance && o) = default;
-
-        /* ----------------------------------------------------------------------------------------
-         * Destructor.
-        */
-        ~Instance() = default;
-
-        /* ----------------------------------------------------------------------------------------
-         * Copy assignment operator.
-        */
-        Instance & operator = (const Instance & o) = default;
-
-        /* ----------------------------------------------------------------------------------------
-         * Move assignment operator.
-        */
-        Instance & operator = (Instance && o) = default;
-    };
+    Fl_Button          *m_ShowReport; // Show the diagnostics of the last generation
 
     // --------------------------------------------------------------------------------------------
-    typedef std::vector< Instance > Instances; // Instance list
+    Fl_Input           *m_TemplateText; // Custom output template
+    Fl_Button          *m_BuildTPL; // Generate data from the custom template
 
-    /* --------------------------------------------------------------------------------------------
-     * Encapsulates character classification for tokenization of the IPL data.
-    */
-    struct Tokens: std::ctype< char >
-    {
-        /* ----------------------------------------------------------------------------------------
-         * Default constructor.
-        */
-        Tokens()
-            : std::ctype< char >(get_table())
-        {
-            /* ... */
-        }
-
-        /* ----------------------------------------------------------------------------------------
-         * Generate and returns the characters to be used by std::basic_istream.
-        */
-        static std::ctype_base::mask const * get_table()
-        {
-            typedef std::ctype< char > cctype;
-            static const cctype::mask * const_rc = cctype::classic_table();
-
-            static cctype::mask rc[cctype::table_size];
-            std::memcpy(rc, const_rc, cctype::table_size * sizeof(cctype::mask));
+    // --------------------------------------------------------------------------------------------
+    Fl_Progress        *m_Progress; // Generation progress
+    Fl_Button          *m_Export; // Write the whole output to a file
+    Fl_Button          *m_Cancel; // Cancel the generation
 
-            rc[','] = std::ctype_base::space;
-            rc[' '] = std::ctype_base::space;
+    // --------------------------------------------------------------------------------------------
+    Fl_Double_Window   *m_Report; // Diagnostics window
+    Fl_Text_Display    *m_ReportBox; // Diagnostics display
+    Fl_Text_Buffer     *m_ReportBuffer; // Diagnostics buffer
 
-            return &rc[0];
-        }
-    };
+    // --------------------------------------------------------------------------------------------
+    std::thread         m_Worker; // Thread that performs the generation
+    std::atomic< bool > m_Cancelled; // Whether the generation should stop
+    std::atomic< int >  m_Percent; // Last progress reported by the worker
+    std::string         m_Path; // Input path used by the worker
+    Template            m_Template; // Compiled template used by the worker
+    InstanceCache       m_Cache; // Instances of the files that were already parsed
+    std::shared_ptr< Instances > m_Instances; // Instances extracted by the worker
+    Diagnostics         m_Diagnostics; // Problems and timings collected by the worker
+    Stopwatch           m_Elapsed; // Measures the whole generation
+    bool                m_Success; // Whether the worker produced any output
 
     /* --------------------------------------------------------------------------------------------
      * Default constructor.
@@ -150,12 +98,30 @@ private:
         , m_InputPath(nullptr)
         , m_InputShow(nullptr)
         , m_InputIcon(nullptr)
-        , m_OutputBox(nullptr)
-        , m_OutputBuffer(nullptr)
+        , m_OutputView(nullptr)
         , m_BuildXML(nullptr)
         , m_BuildNUT(nullptr)
         , m_BuildRAW(nullptr)
         , m_FuncName(nullptr)
+        , m_ShowReport(nullptr)
+        , m_TemplateText(nullptr)
+        , m_BuildTPL(nullptr)
+        , m_Progress(nullptr)
+        , m_Export(nullptr)
+        , m_Cancel(nullptr)
+        , m_Report(nullptr)
+        , m_ReportBox(nullptr)
+        , m_ReportBuffer(nullptr)
+        , m_Worker()
+        , m_Cancelled(false)
+        , m_Percent(0)
+        , m_Path()
+        , m_Template()
+        , m_Cache()
+        , m_Instances()
+        , m_Diagnostics()
+        , m_Elapsed()
+        , m_Success(false)
     {
         this->begin();
         // ----------------------------------------------------------------------------------------
@@ -172,10 +138,7 @@ private:
         m_InputIcon = Fl_File_Icon::find(".", Fl_File_Icon::DIRECTORY);
         m_InputIcon->label(m_InputShow);
         // ----------------------------------------------------------------------------------------
-        m_OutputBox = new Fl_Text_Display(8, 86, 622, 384);
-        // ----------------------------------------------------------------------------------------
-        m_OutputBuffer = new Fl_Text_Buffer(1024 * 1024 * 4);
-        m_OutputBox->buffer(m_OutputBuffer);
+        m_OutputView = new OutputView(8, 118, 622, 320);
         // ----------------------------------------------------------------------------------------
         m_BuildXML = new Fl_Button(8, 48, 48, 24, "XML");
         m_BuildXML->callback(&App::BuildXMLCallback);
@@ -186,10 +149,46 @@ private:
         m_BuildRAW = new Fl_Button(120, 48, 48, 24, "RAW");
         m_BuildRAW->callback(&App::BuildRAWCallback);
         // ----------------------------------------------------------------------------------------
-        m_FuncName = new Fl_Input(250, 48, 380, 24, "Function:");
+        m_FuncName = new Fl_Input(250, 48, 316, 24, "Function:");
         m_FuncName->value("HideMapObject");
         // ----------------------------------------------------------------------------------------
+        m_ShowReport = new Fl_Button(574, 48, 56, 24, "Report");
+        m_ShowReport->callback(&App::ShowReportCallback);
+        m_ShowReport->deactivate();
+        // ----------------------------------------------------------------------------------------
+        m_TemplateText = new Fl_Input(72, 86, 494, 24, "Template:");
+        m_TemplateText->value("{func}({id}, {x:raw}, {y:raw}, {z:raw});");
+        // ----------------------------------------------------------------------------------------
+        m_BuildTPL = new Fl_Button(574, 86, 56, 24, "Custom");
+        m_BuildTPL->callback(&App::BuildTPLCallback);
+        // ----------------------------------------------------------------------------------------
+        m_Progress = new Fl_Progress(8, 446, 494, 24);
+        m_Progress->minimum(0.0f);
+        m_Progress->maximum(100.0f);
+        m_Progress->value(0.0f);
+        // ----------------------------------------------------------------------------------------
+        m_Export = new Fl_Button(510, 446, 56, 24, "Export");
+        m_Export->callback(&App::ExportCallback);
+        m_Export->deactivate();
+        // ----------------------------------------------------------------------------------------
+        m_Cancel = new Fl_Button(574, 446, 56, 24, "Cancel");
+        m_Cancel->callback(&App::CancelCallback);
+        m_Cancel->deactivate();
+        // ----------------------------------------------------------------------------------------
         this->end();
+        // ----------------------------------------------------------------------------------------
+        m_Report = new Fl_Double_Window(560, 320, "Diagnostics");
+        // ----------------------------------------------------------------------------------------
+        m_ReportBox = new Fl_Text_Display(8, 8, 544, 304);
+        m_ReportBox->textfont(FL_COURIER);
+        // ----------------------------------------------------------------------------------------
+        m_ReportBuffer = new Fl_Text_Buffer();
+        m_ReportBox->buffer(m_ReportBuffer);
+        // ----------------------------------------------------------------------------------------
+        m_Report->resizable(m_ReportBox);
+        m_Report->end();
+        // ----------------------------------------------------------------------------------------
+        this->callback(&App::CloseCallback);
     }
 
     /* --------------------------------------------------------------------------------------------
@@ -223,7 +222,7 @@ public:
     */
     virtual ~App()
     {
-        /* ... */
+        Stop();
     }
 
     /* --------------------------------------------------------------------------------------------
@@ -244,277 +243,230 @@ public:
     */
     void Exit()
     {
+        Stop();
         std::exit(EXIT_SUCCESS);
     }
 
+    /* --------------------------------------------------------------------------------------------
+     * Cancel any generation in progress and wait for the worker to finish.
+    */
+    void Stop()
+    {
+        if (m_Worker.joinable())
+        {
+            m_Cancelled = true;
+            m_Worker.join();
+        }
+    }
+
     /* --------------------------------------------------------------------------------------------
      * Generate XML output from the selected IPL file.
     */
     void BuildXML()
     {
-        // Allocate a list of instances
-        Instances inst_list;
-        // Populate the list with elements from the selected IPL file
-        if (!Extract(inst_list))
+        Generate(Format::XML);
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Generate NUT output from the selected IPL file.
+    */
+    void BuildNUT()
+    {
+        Generate(Format::NUT);
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Generate RAW NUT output from the selected IPL file.
+    */
+    void BuildRAW()
+    {
+        Generate(Format::RAW);
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Generate output from the selected IPL file using the custom template.
+    */
+    void BuildTPL()
+    {
+        Generate(m_TemplateText->value(), true);
+    }
+
+protected:
+
+    /* --------------------------------------------------------------------------------------------
+     * Start generating output of the specified format from the selected IPL file.
+    */
+    void Generate(Format fmt)
+    {
+        Generate(FormatTemplate(fmt), false);
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Start generating output from the selected IPL file using the specified template.
+    */
+    void Generate(const char * pattern, bool line)
+    {
+        // Is there a generation in progress already?
+        if (m_Worker.joinable())
         {
-            return; // Nothing to process
+            return; // One at a time!
         }
-        // Clear any previous data from the buffer
-        m_OutputBuffer->text("");
-        // Buffer for the generated rule
-        char buffer[512] = {0};
-        // Format result and line count
-        int ret = 0, lnum  = 0;
-        // Process all instances in the list
-        for (const auto & inst : inst_list)
+        std::string error;
+        // Compile the template before bothering the worker
+        if (!(line ? m_Template.CompileLine(pattern, m_FuncName->value(), error)
+                    : m_Template.Compile(pattern, m_FuncName->value(), error)))
         {
-            // Advance the line count
-            ++lnum;
-            // Attempt to generate the map rule
-            ret = std::snprintf(buffer, sizeof(buffer),
-                "<rule model=\"%d\">\n\t<position x=\"%f\" y=\"%f\" z=\"%f\" />\n</rule>\n",
-                inst.mID, inst.mX, inst.mY, inst.mZ);
-            // Did an error occurred?
-            if (ret < 0)
-            {
-                fl_alert("A format error occurred at line: %d", lnum);
-                // We're done here
-                return;
-            }
-            // Did we have enough buffer?
-            else if (static_cast< unsigned >(ret) > sizeof(buffer))
-            {
-                fl_alert("A buffer overflow occurred at line: %d", lnum);
-                // We're done here
-                return;
-            }
-            // Add the resulted rule string to the buffer
-            m_OutputBuffer->append(buffer);
+            fl_alert("%s", error.c_str());
+            // We're done here
+            return;
         }
+        // Widgets must not be touched from the worker
+        m_Path = m_InputPath->value();
+        // Reset the state shared with the worker
+        m_Instances = std::make_shared< Instances >();
+        m_Diagnostics.Clear();
+        m_Elapsed.Lap();
+        m_Success = false;
+        m_Cancelled = false;
+        m_Percent = 0;
+        // Prevent another generation until this one is done
+        m_BuildXML->deactivate();
+        m_BuildNUT->deactivate();
+        m_BuildRAW->deactivate();
+        m_BuildTPL->deactivate();
+        m_Export->deactivate();
+        m_Cancel->activate();
+        // Reset the progress
+        m_Progress->value(0.0f);
+        m_Progress->label("Parsing...");
+        // Let the worker do the rest
+        m_Worker = std::thread(&App::Work, this);
     }
 
     /* --------------------------------------------------------------------------------------------
-     * Generate NUT output from the selected IPL file.
+     * Extract the instances from the selected IPL file. The output view generates the rows it
+     * displays on its own. (worker thread)
     */
-    void BuildNUT()
+    void Work()
     {
-        // Allocate a list of instances
-        Instances inst_list;
+        // Problems are only displayed once the worker is done
+        const Reporter report = m_Diagnostics.Bind(m_Diagnostics.AddFile(m_Path));
+        // Parsing takes the whole progress bar
+        Progress parsing = [this](size_t done, size_t total) {
+            return Advance(static_cast< int >(done * 100 / (total ? total : 1)));
+        };
         // Populate the list with elements from the selected IPL file
-        if (!Extract(inst_list))
+        m_Success = m_Cache.Extract(m_Path.c_str(), *m_Instances, report, parsing,
+                                    &m_Diagnostics.Times());
+        // Let the interface know that we're done
+        Fl::awake(&App::FinishAwake, this);
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Update the progress of the worker. Returns whether the worker should continue.
+    */
+    bool Advance(int percent)
+    {
+        // Only wake the interface when the progress is visibly different
+        if (m_Percent.exchange(percent) != percent)
         {
-            return; // Nothing to process
+            Fl::awake(&App::ProgressAwake, this);
         }
-        // Clear any previous data from the buffer
-        m_OutputBuffer->text("");
-        // Buffer for the generated line of code
-        char buffer[512] = {0};
-        // Format result and line count
-        int ret = 0, lnum  = 0;
-        // Process all instances in the list
-        for (const auto & inst : inst_list)
+        // Let the worker know whether it should continue
+        return !m_Cancelled;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Display the progress reported by the worker.
+    */
+    static void ProgressAwake(void * /*p*/)
+    {
+        // Did the worker finish already?
+        if (!s_App->m_Worker.joinable())
         {
-            // Advance the line count
-            ++lnum;
-            // Attempt to generate the function call code
-            ret = std::snprintf(buffer, sizeof(buffer), "%s(%d, %f, %f, %f);\n",
-                                m_FuncName->value(), inst.mID, inst.mX, inst.mY, inst.mZ);
-            // Did an error occurred?
-            if (ret < 0)
-            {
-                fl_alert("A format error occurred at line: %d", lnum);
-                // We're done here
-                return;
-            }
-            // Did we have enough buffer?
-            else if (static_cast< unsigned >(ret) > sizeof(buffer))
-            {
-                fl_alert("A buffer overflow occurred at line: %d", lnum);
-                // We're done here
-                return;
-            }
-            // Add the resulted code string to the buffer
-            m_OutputBuffer->append(buffer);
+            return; // Stale update
         }
+        const int percent = s_App->m_Percent;
+        // Update the progress bar
+        s_App->m_Progress->value(static_cast< float >(percent));
+        s_App->m_Progress->label("Parsing...");
     }
 
     /* --------------------------------------------------------------------------------------------
-     * Generate RAW NUT output from the selected IPL file.
+     * Display the results produced by the worker.
     */
-    void BuildRAW()
+    static void FinishAwake(void * /*p*/)
     {
-        // Allocate a list of instances
-        Instances inst_list;
-        // Populate the list with elements from the selected IPL file
-        if (!Extract(inst_list))
+        App & app = *s_App;
+        // Was the worker already stopped?
+        if (!app.m_Worker.joinable())
+        {
+            return; // Nothing to display
+        }
+        // Wait for the worker to exit
+        app.m_Worker.join();
+        // Allow another generation
+        app.m_BuildXML->activate();
+        app.m_BuildNUT->activate();
+        app.m_BuildRAW->activate();
+        app.m_BuildTPL->activate();
+        app.m_Cancel->deactivate();
+        // Reset the progress
+        app.m_Progress->value(0.0f);
+        app.m_Progress->label(app.m_Cancelled ? "Cancelled" : nullptr);
+        // Was anything extracted?
+        if (app.m_Success && !app.m_Cancelled)
         {
-            return; // Nothing to process
+            Stopwatch watch;
+            // Let the display generate the rows it shows
+            app.m_OutputView->Show(app.m_Instances, app.m_Template);
+            app.m_Diagnostics.Times().Add(Stage::Display, watch.Lap());
+            app.m_Export->activate();
         }
-        // Clear any previous data from the buffer
-        m_OutputBuffer->text("");
-        // Buffer for the generated line of code
-        char buffer[512] = {0};
-        // Format result and line count
-        int ret = 0, lnum  = 0;
-        // Computed coordinates
-        int x = 0, y = 0, z = 0;
-        // Process all instances in the list
-        for (const auto & inst : inst_list)
+        app.m_Diagnostics.Times().mElapsed = app.m_Elapsed.Lap();
+        // Update the diagnostics
+        app.m_ReportBuffer->text(app.m_Diagnostics.Summary().c_str());
+        app.m_ShowReport->activate();
+        // Bring them up on their own when there were problems
+        if (!app.m_Diagnostics.Problems().empty())
         {
-            // Advance the line count
-            ++lnum;
-            // Compute coordinates
-            x = static_cast< int >(std::floor(inst.mX * 10.0) + 0.5);
-            y = static_cast< int >(std::floor(inst.mY * 10.0) + 0.5);
-            z = static_cast< int >(std::floor(inst.mZ * 10.0) + 0.5);
-            // Attempt to generate the function call code
-            ret = std::snprintf(buffer, sizeof(buffer), "%s(%d, %d, %d, %d);\n",
-                                m_FuncName->value(), inst.mID, x, y, z);
-            // Did an error occurred?
-            if (ret < 0)
-            {
-                fl_alert("A format error occurred at line: %d", lnum);
-                // We're done here
-                return;
-            }
-            // Did we have enough buffer?
-            else if (static_cast< unsigned >(ret) > sizeof(buffer))
-            {
-                fl_alert("A buffer overflow occurred at line: %d", lnum);
-                // We're done here
-                return;
-            }
-            // Add the resulted code string to the buffer
-            m_OutputBuffer->append(buffer);
+            app.m_Report->show();
         }
     }
 
-protected:
-
-    // --------------------------------------------------------------------------------------------
-    typedef std::vector< std::string > Strings;
-
     /* --------------------------------------------------------------------------------------------
-     * Explode the specified instance definition into individual values.
+     * Close the diagnostics along with the main window.
     */
-    static Strings Explode(const std::string & str)
+    static void CloseCallback(Fl_Widget * /*w*/, void * /*p*/)
     {
-        // Obtain a stream fro the specified string
-        std::stringstream ss(str);
-        // Associate our custom locale with the stream
-        ss.imbue(std::locale(std::locale(), new Tokens()));
-        // Construct and return a vector with the extracted tokens
-        return Strings(std::istream_iterator< std::string >(ss),
-                        std::istream_iterator< std::string >());
+        s_App->m_Report->hide();
+        s_App->hide();
     }
 
     /* --------------------------------------------------------------------------------------------
-     * Extract the values from the specified IPL file.
+     * Write the whole output to a file.
     */
-    bool Extract(Instances & inst_list)
+    static void ExportCallback(Fl_Widget * /*w*/, void * /*p*/)
     {
-        // Characters that represent a space
-        static const char schars[] = {' ', '\t', '\n', '\v', '\f', '\r', '\0'};
-        // Retrieve the path from the input widget
-        const char * iplpath = m_InputPath->value();
-        // See if a path was selected and whether its valid
-        if (!iplpath || *iplpath == '\0')
+        const char * path = fl_file_chooser("Export the output to...", "*", nullptr);
+        // Was a file selected?
+        if (path == nullptr)
         {
-            fl_alert("No IPL file selected");
-            // We're done here
-            return false;
+            return; // Nothing to do
         }
-        // Attempt to open the specified file
-        std::ifstream iplfile(iplpath);
-        // See if the file could be opened
-        if (!iplfile.is_open())
+        // Stream the output to the file
+        if (!s_App->m_OutputView->Export(path))
         {
-            fl_alert("Unable to open the selected file");
-            // We're done here
-            return false;
+            fl_alert("Unable to write the output to: %s", path);
         }
-        // String where the current line is retrieved
-        std::string line;
-        // Whether the we reached the instances section
-        bool in_inst = false;
-        // Line count
-        int lnum = 0;
-        // Process the file line by line
-        while (std::getline(iplfile, line))
-        {
-            // Advance the line count
-            ++lnum;
-            // Is the first character a space?
-            if (std::isspace(line.front()) != 0)
-            {
-                // Find the first non space character
-                std::string::size_type pos = line.find_first_not_of(schars);
-                // Have we found anything?
-                if (pos == std::string::npos)
-                {
-                    continue; // Skip this line!
-                }
-                // Slice out the space portion
-                line = line.substr(pos);
-            }
-            // Is this line a comment?
-            if (line.front() == '#')
-            {
-                continue; // Nothing to process here!
-            }
-            // Are we supposed to stop processing instances?
-            if (in_inst && line.compare("end") == 0)
-            {
-                break; // Nothing left to parse!
-            }
-            // Are we supposed to process an instance?
-            else if (in_inst)
-            {
-                // The list of individual values from the line
-                Strings args;
-                // Extract the individual values from the string
-                try
-                {
-                    args = Explode(line);
-                }
-                catch (...)
-                {
-                    fl_alert("Error while tokenizing line: %d", lnum);
-                    // Skip this line...
-                    continue;
-                }
-                // Do we even have enough values?
-                if (args.size() < 6)
-                {
-                    fl_alert("Wrong number of tokens at line: %d", lnum);
-                    // This instance is incomplete!
-                    continue;
-                }
-                // Attempt to add this instance to the list
-                try
-                {
-                    inst_list.emplace_back(
-                        std::stoi(args[0], nullptr, 10),
-                        std::stod(args[3], nullptr),
-                        std::stod(args[4], nullptr),
-                        std::stod(args[5], nullptr)
-                    );
-                }
-                catch (...)
-                {
-                    fl_alert("Unable to extract values at line: %d", lnum);
-                }
-            }
-            else if (line.compare("inst") == 0)
-            {
-                // We entered the instance section
-                in_inst = true;
-                // Skip this line
-                continue;
-            }
-        }
-        // Return whether we have anything to give to the caller
-        return (in_inst && !inst_list.empty());
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Show the diagnostics of the last generation.
+    */
+    static void ShowReportCallback(Fl_Widget * /*w*/, void * /*p*/)
+    {
+        s_App->m_Report->show();
     }
 
     /* --------------------------------------------------------------------------------------------
@@ -560,6 +512,22 @@ protected:
     {
         s_App->BuildRAW();
     }
+
+    /* --------------------------------------------------------------------------------------------
+     * Generate output from the selected IPL file using the custom template.
+    */
+    static void BuildTPLCallback(Fl_Widget * /*w*/, void * /*p*/)
+    {
+        s_App->BuildTPL();
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Cancel the generation in progress.
+    */
+    static void CancelCallback(Fl_Widget * /*w*/, void * /*p*/)
+    {
+        s_App->m_Cancelled = true;
+    }
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -575,9 +543,19 @@ App * App::s_App = nullptr;
 int main(int argc, char **argv)
 {
     using namespace VcMp;
+    // Was the headless mode requested?
+    if (IsBatch(argc, argv))
+    {
+        return RunBatch(argc, argv);
+    }
+    // Allow the worker to wake the interface
+    Fl::lock();
     Fl::scheme(nullptr);
     Fl_File_Icon::load_system_icons();
     App * w = App::Get();
     w->show(argc, argv);
-    return Fl::run();
+    const int ret = Fl::run();
+    // Don't leave a worker running behind
+    w->Stop();
+    return ret;
 }
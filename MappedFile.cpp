@@ -0,0 +1,120 @@
+// ------------------------------------------------------------------------------------------------
+#include "MappedFile.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+MappedFile::MappedFile(const char * path)
+    : m_Data(nullptr), m_Size(0), m_Open(false)
+{
+#ifdef _WIN32
+    // Attempt to open the specified file
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return; // Nothing to map
+    }
+    LARGE_INTEGER size;
+    // Retrieve the file size and see if there's anything to map
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+        {
+            m_Data = static_cast< const char * >(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            // The view keeps the mapping alive
+            CloseHandle(mapping);
+        }
+        // Only consider the file open if the contents were mapped
+        m_Size = m_Data ? static_cast< size_t >(size.QuadPart) : 0;
+        m_Open = (m_Data != nullptr);
+    }
+    else
+    {
+        m_Open = (size.QuadPart == 0);
+    }
+    // The view keeps the file alive
+    CloseHandle(file);
+#else
+    // Attempt to open the specified file
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return; // Nothing to map
+    }
+    struct stat st;
+    // Retrieve the file size and make sure this is something we can map
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        // Empty files cannot be mapped but are perfectly valid
+        if (st.st_size > 0)
+        {
+            void * addr = mmap(nullptr, static_cast< size_t >(st.st_size), PROT_READ,
+                                MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                // The contents are read from start to end
+                madvise(addr, static_cast< size_t >(st.st_size), MADV_SEQUENTIAL);
+                // Store the mapped contents
+                m_Data = static_cast< const char * >(addr);
+                m_Size = static_cast< size_t >(st.st_size);
+                m_Open = true;
+            }
+        }
+        else
+        {
+            m_Open = true;
+        }
+    }
+    // The mapping keeps the file alive
+    close(fd);
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+void MappedFile::Discard(size_t beg, size_t end) const
+{
+#ifdef _WIN32
+    // The system trims the pages of mapped files on its own
+    static_cast< void >(beg), static_cast< void >(end);
+#else
+    const size_t page = static_cast< size_t >(sysconf(_SC_PAGESIZE));
+    // Only whole pages can be discarded
+    beg = (beg + page - 1) / page * page;
+    end = (end < m_Size ? end : m_Size) / page * page;
+    // Is there anything to discard?
+    if (m_Data != nullptr && beg < end)
+    {
+        madvise(const_cast< char * >(m_Data) + beg, end - beg, MADV_DONTNEED);
+    }
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+    // Is there anything to release?
+    if (m_Data == nullptr)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+#else
+    munmap(const_cast< char * >(m_Data), m_Size);
+#endif
+}
+
+} // Namespace:: VcMp
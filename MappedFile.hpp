@@ -0,0 +1,84 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Read-only view of a whole file mapped into memory.
+*/
+class MappedFile
+{
+private:
+
+    // --------------------------------------------------------------------------------------------
+    const char *    m_Data; // Start of the mapped contents
+    size_t          m_Size; // Size of the mapped contents
+    bool            m_Open; // Whether the file could be opened
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor. Maps the specified file.
+    */
+    explicit MappedFile(const char * path);
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy constructor. (disabled)
+    */
+    MappedFile(const MappedFile &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Move constructor. (disabled)
+    */
+    MappedFile(MappedFile &&) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Destructor. Releases the mapping.
+    */
+    ~MappedFile();
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy assignment operator. (disabled)
+    */
+    MappedFile & operator = (const MappedFile &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Move assignment operator. (disabled)
+    */
+    MappedFile & operator = (MappedFile &&) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether the file could be opened. An empty file is open but has no data.
+    */
+    bool IsOpen() const
+    {
+        return m_Open;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the start of the mapped contents.
+    */
+    const char * Data() const
+    {
+        return m_Data;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the size of the mapped contents.
+    */
+    size_t Size() const
+    {
+        return m_Size;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Let the system reclaim the memory behind the specified range of the contents, which will
+     * be read from the file again if accessed. Only whole pages inside the range are affected.
+    */
+    void Discard(size_t beg, size_t end) const;
+};
+
+} // Namespace:: VcMp
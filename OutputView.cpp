@@ -0,0 +1,261 @@
+// ------------------------------------------------------------------------------------------------
+#include "OutputView.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdio>
+
+// ------------------------------------------------------------------------------------------------
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+const int           ScrollWidth = 16; // Width of the scroll bar
+const int           TextMargin = 4; // Space between the frame and the text
+const Fl_Font       TextFont = FL_COURIER; // Font of the rows
+const Fl_Fontsize   TextSize = 14; // Size of the rows
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+OutputView::OutputView(int x, int y, int w, int h, const char * label)
+    : Fl_Group(x, y, w, h, label)
+    , m_Scroll(nullptr)
+    , m_Instances()
+    , m_Template()
+    , m_PerInstance(1)
+    , m_Top(0)
+    , m_Scratch()
+    , m_Lines()
+    , m_Cached(static_cast< size_t >(-1))
+{
+    box(FL_DOWN_BOX);
+    color(FL_BACKGROUND2_COLOR);
+    // ----------------------------------------------------------------------------------------
+    m_Scroll = new Fl_Scrollbar(x + w - ScrollWidth, y, ScrollWidth, h);
+    m_Scroll->type(FL_VERTICAL);
+    m_Scroll->linesize(1);
+    m_Scroll->callback(&OutputView::ScrollCallback, this);
+    // ----------------------------------------------------------------------------------------
+    end();
+    UpdateScroll();
+}
+
+// ------------------------------------------------------------------------------------------------
+void OutputView::Show(const std::shared_ptr< const Instances > & inst_list, const Template & tpl)
+{
+    m_Instances = inst_list;
+    m_Template = tpl;
+    // Templates without line breaks still get a row for every instance
+    m_PerInstance = std::max< size_t >(m_Template.Lines(), 1);
+    // Forget the rows of the previous output
+    m_Cached = static_cast< size_t >(-1);
+    m_Top = 0;
+    // Show the start of the new output
+    UpdateScroll();
+    redraw();
+}
+
+// ------------------------------------------------------------------------------------------------
+void OutputView::Reset()
+{
+    m_Instances.reset();
+    m_Cached = static_cast< size_t >(-1);
+    m_Top = 0;
+    // Nothing to show anymore
+    UpdateScroll();
+    redraw();
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t OutputView::Rows() const
+{
+    return m_Instances ? m_Instances->size() * m_PerInstance : 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool OutputView::Export(const char * path) const
+{
+    std::FILE * file = std::fopen(path, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    // Stream the output to the file one chunk at a time
+    Writer out(file);
+    if (m_Instances)
+    {
+        m_Template.Emit(*m_Instances, out);
+    }
+    bool ok = out.Flush();
+    // Make sure everything reached the file
+    ok = (std::fclose(file) == 0) && ok;
+    // Report whether the output was written
+    return ok;
+}
+
+// ------------------------------------------------------------------------------------------------
+void OutputView::resize(int x, int y, int w, int h)
+{
+    Fl_Widget::resize(x, y, w, h);
+    // Keep the scroll bar on the right side
+    m_Scroll->resize(x + w - ScrollWidth, y, ScrollWidth, h);
+    // More or fewer rows may fit now
+    UpdateScroll();
+}
+
+// ------------------------------------------------------------------------------------------------
+void OutputView::draw()
+{
+    // Draw the frame and the background
+    fl_draw_box(box(), x(), y(), w(), h(), color());
+    // The area where text goes
+    const int tx = x() + TextMargin, ty = y() + TextMargin;
+    const int tw = w() - ScrollWidth - TextMargin * 2, th = h() - TextMargin * 2;
+    fl_push_clip(tx, ty, tw, th);
+    fl_font(TextFont, TextSize);
+    fl_color(FL_FOREGROUND_COLOR);
+    const int lh = fl_height();
+    // Generate and draw only the visible rows
+    const size_t rows = Rows(), last = std::min(rows, m_Top + Visible() + 1);
+    for (size_t r = m_Top; r < last; ++r)
+    {
+        const int ry = ty + static_cast< int >(r - m_Top) * lh;
+        fl_draw(Row(r).c_str(), tx, ry + lh - fl_descent());
+    }
+    fl_pop_clip();
+    // Draw the scroll bar on top
+    draw_children();
+}
+
+// ------------------------------------------------------------------------------------------------
+int OutputView::handle(int event)
+{
+    switch (event)
+    {
+        // Accept the focus so the keyboard can be used
+        case FL_FOCUS:
+        case FL_UNFOCUS:
+            return 1;
+        // Scroll three rows for every step of the wheel
+        case FL_MOUSEWHEEL:
+        {
+            const long dy = static_cast< long >(Fl::event_dy()) * 3;
+            ScrollTo(dy < 0 && static_cast< size_t >(-dy) > m_Top ? 0 : m_Top + dy);
+            return 1;
+        }
+        // Take the focus when clicked, unless the scroll bar was clicked
+        case FL_PUSH:
+        {
+            if (Fl::event_inside(m_Scroll))
+            {
+                break;
+            }
+            take_focus();
+            return 1;
+        }
+        case FL_KEYBOARD:
+        {
+            const size_t page = std::max< size_t >(Visible(), 1);
+            // Move through the rows
+            switch (Fl::event_key())
+            {
+                case FL_Up: ScrollTo(m_Top > 0 ? m_Top - 1 : 0); return 1;
+                case FL_Down: ScrollTo(m_Top + 1); return 1;
+                case FL_Page_Up: ScrollTo(m_Top > page ? m_Top - page : 0); return 1;
+                case FL_Page_Down: ScrollTo(m_Top + page); return 1;
+                case FL_Home: ScrollTo(0); return 1;
+                case FL_End: ScrollTo(Rows()); return 1;
+                default: break;
+            }
+        } break;
+        default: break;
+    }
+    // Let the scroll bar have the rest
+    return Fl_Group::handle(event);
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t OutputView::Visible() const
+{
+    fl_font(TextFont, TextSize);
+    // Count the whole rows that fit
+    return static_cast< size_t >(std::max(h() - TextMargin * 2, 0) / std::max(fl_height(), 1));
+}
+
+// ------------------------------------------------------------------------------------------------
+void OutputView::ScrollTo(size_t row)
+{
+    const size_t rows = Rows(), page = Visible();
+    // Don't scroll past the last page
+    m_Top = std::min(row, rows > page ? rows - page : 0);
+    UpdateScroll();
+    redraw();
+}
+
+// ------------------------------------------------------------------------------------------------
+void OutputView::UpdateScroll()
+{
+    const size_t rows = Rows(), page = Visible();
+    // Keep the first row within the output
+    m_Top = std::min(m_Top, rows > page ? rows - page : 0);
+    m_Scroll->value(static_cast< int >(m_Top), static_cast< int >(std::min(page, rows)), 0,
+                    static_cast< int >(rows));
+}
+
+// ------------------------------------------------------------------------------------------------
+const std::string & OutputView::Row(size_t row)
+{
+    const size_t inst = row / m_PerInstance;
+    // Generate the rows of this instance, unless we already have them
+    if (inst != m_Cached)
+    {
+        m_Scratch.Clear();
+        m_Template.Emit((*m_Instances)[inst], m_Scratch);
+        const std::string text = m_Scratch.Str();
+        // Split the output into rows
+        m_Lines.clear();
+        for (size_t beg = 0; beg < text.size(); )
+        {
+            const size_t end = std::min(text.find('\n', beg), text.size());
+            m_Lines.emplace_back();
+            // Expand the tabs since they are not drawn
+            for (size_t i = beg; i < end; ++i)
+            {
+                if (text[i] == '\t')
+                {
+                    m_Lines.back().append(4 - m_Lines.back().size() % 4, ' ');
+                }
+                else
+                {
+                    m_Lines.back().push_back(text[i]);
+                }
+            }
+            beg = end + 1;
+        }
+        // Every instance is expected to have the same number of rows
+        m_Lines.resize(m_PerInstance);
+        m_Cached = inst;
+    }
+    // Return the requested row
+    return m_Lines[row % m_PerInstance];
+}
+
+// ------------------------------------------------------------------------------------------------
+void OutputView::ScrollCallback(Fl_Widget * /*w*/, void * p)
+{
+    OutputView * view = static_cast< OutputView * >(p);
+    // Follow the scroll bar
+    view->m_Top = static_cast< size_t >(view->m_Scroll->value());
+    view->redraw();
+}
+
+} // Namespace:: VcMp
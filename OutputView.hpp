@@ -0,0 +1,114 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+#include "Template.hpp"
+#include "Writer.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <memory>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Scrollbar.H>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Displays the output of a list of instances without generating it. Only the rows that are
+ * visible are generated, each time they are drawn, so the memory used depends on the size of
+ * the view rather than the size of the output.
+*/
+class OutputView : public Fl_Group
+{
+private:
+
+    // --------------------------------------------------------------------------------------------
+    Fl_Scrollbar *                      m_Scroll; // Vertical scroll bar
+    std::shared_ptr< const Instances >  m_Instances; // Instances being displayed
+    Template                            m_Template; // Generates the output of each instance
+    size_t                              m_PerInstance; // Rows generated by each instance
+    size_t                              m_Top; // First visible row
+    Writer                              m_Scratch; // Output of the instance being drawn
+    std::vector< std::string >          m_Lines; // Rows of the instance being drawn
+    size_t                              m_Cached; // Instance the rows belong to
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor.
+    */
+    OutputView(int x, int y, int w, int h, const char * label = nullptr);
+
+    /* --------------------------------------------------------------------------------------------
+     * Display the output of the specified instances, generated with the specified template.
+    */
+    void Show(const std::shared_ptr< const Instances > & inst_list, const Template & tpl);
+
+    /* --------------------------------------------------------------------------------------------
+     * Stop displaying anything.
+    */
+    void Reset();
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of rows in the output.
+    */
+    size_t Rows() const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Write the whole output to the specified file.
+    */
+    bool Export(const char * path) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Update the position of the children.
+    */
+    void resize(int x, int y, int w, int h) override;
+
+protected:
+
+    /* --------------------------------------------------------------------------------------------
+     * Draw the visible rows.
+    */
+    void draw() override;
+
+    /* --------------------------------------------------------------------------------------------
+     * Scroll with the mouse wheel and the keyboard.
+    */
+    int handle(int event) override;
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of rows that fit in the view.
+    */
+    size_t Visible() const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Move the first visible row, keeping it within the output.
+    */
+    void ScrollTo(size_t row);
+
+    /* --------------------------------------------------------------------------------------------
+     * Update the scroll bar after the output or the size of the view changed.
+    */
+    void UpdateScroll();
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the text of the specified row.
+    */
+    const std::string & Row(size_t row);
+
+    /* --------------------------------------------------------------------------------------------
+     * Follow the scroll bar.
+    */
+    static void ScrollCallback(Fl_Widget * w, void * p);
+};
+
+} // Namespace:: VcMp
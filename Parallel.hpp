@@ -0,0 +1,66 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the number of workers to use when none was explicitly requested.
+*/
+inline unsigned DefaultJobs()
+{
+    const unsigned n = std::thread::hardware_concurrency();
+    // The implementation is allowed to not know
+    return n ? n : 1;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Invoke the specified function once for every index in [0, count) across a pool of workers.
+ * Each worker claims the next unprocessed index so uneven tasks still balance out.
+*/
+template < typename F > void ParallelFor(size_t count, unsigned jobs, F && fn)
+{
+    // Never spawn more workers than there are tasks
+    jobs = static_cast< unsigned >(std::min< size_t >(std::max(jobs, 1u), count));
+    // Is it even worth spawning any threads?
+    if (jobs <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            fn(i);
+        }
+        // We're done here
+        return;
+    }
+    // The next index to be claimed by a worker
+    std::atomic< size_t > next(0);
+    // The worker routine
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            fn(i);
+        }
+    };
+    // The spawned workers
+    std::vector< std::thread > pool;
+    pool.reserve(jobs - 1);
+    // The calling thread is also a worker
+    for (unsigned n = 1; n < jobs; ++n)
+    {
+        pool.emplace_back(work);
+    }
+    work();
+    // Wait for everyone to finish
+    for (auto & t : pool)
+    {
+        t.join();
+    }
+}
+
+} // Namespace:: VcMp
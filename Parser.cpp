@@ -0,0 +1,513 @@
+// ------------------------------------------------------------------------------------------------
+#include "Parser.hpp"
+#include "Scanner.hpp"
+#include "MappedFile.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstring>
+
+// ------------------------------------------------------------------------------------------------
+#include <charconv>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * See whether the specified value is the specified section marker.
+*/
+inline bool IsMarker(const char * beg, const char * end, const char * marker, size_t len)
+{
+    return (static_cast< size_t >(end - beg) == len && std::memcmp(beg, marker, len) == 0);
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Convert the leading portion of the specified value to a number. Like the standard stoi/stod
+ * functions, an explicit plus sign is accepted and trailing characters are ignored.
+*/
+template < typename T > bool ToNumber(const char * beg, const char * end, T & val)
+{
+    // Skip the plus sign since from_chars does not accept it
+    if (*beg == '+' && beg + 1 < end && beg[1] != '-')
+    {
+        ++beg;
+    }
+    // Attempt to convert the value
+    return std::from_chars(beg, end, val).ec == std::errc();
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * The values of a line within the data it was found in.
+*/
+struct Fields
+{
+    // --------------------------------------------------------------------------------------------
+    const char *            mData; // Data the line was found in
+    const Scanner::Line &   mLine; // Offsets of the values
+
+    /* --------------------------------------------------------------------------------------------
+     * Convert the specified value to a number. Values that are not present leave the number alone.
+    */
+    template < typename T > bool Get(size_t i, T & val) const
+    {
+        return i >= mLine.mCount || ToNumber(mData + mLine.mBeg[i], mData + mLine.mEnd[i], val);
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Convert the specified values to numbers.
+    */
+    template < typename T > bool Get(size_t i, T * val, size_t count) const
+    {
+        for (size_t n = 0; n < count; ++n)
+        {
+            if (!Get(i + n, val[n]))
+            {
+                return false;
+            }
+        }
+        // All values were converted
+        return true;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the specified value as it was written.
+    */
+    std::string Str(size_t i) const
+    {
+        return std::string(mData + mLine.mBeg[i], mData + mLine.mEnd[i]);
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the line number, as expected by the reporter.
+    */
+    int Number() const
+    {
+        return static_cast< int >(mLine.mNumber);
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Report a value that could not be converted.
+*/
+inline void BadValues(const Fields & f, const Reporter & report)
+{
+    report(Category::Values, "Unable to extract values at line", f.Number());
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract an instance. (ID, ModelName, Interior, PosX, PosY, PosZ, ...)
+*/
+void ParseInst(const Fields & f, Sections & out, const Reporter & report)
+{
+    int id = 0;
+    double pos[3] = {0.0, 0.0, 0.0};
+    // Attempt to add this instance to the list
+    if (f.Get(0, id) && f.Get(3, pos, 3))
+    {
+        out.mInst.emplace_back(id, pos[0], pos[1], pos[2]);
+    }
+    else
+    {
+        BadValues(f, report);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract a culling zone. (CenterX, CenterY, CenterZ, MinX, MinY, MinZ, MaxX, MaxY, MaxZ, Flags,
+ * WantedLevelDrop)
+*/
+void ParseCull(const Fields & f, Sections & out, const Reporter & report)
+{
+    CullZone cull{};
+    // Attempt to add this zone to the list
+    if (f.Get(0, cull.mCenter, 3) && f.Get(3, cull.mMin, 3) && f.Get(6, cull.mMax, 3) &&
+        f.Get(9, cull.mFlags) && f.Get(10, cull.mWanted))
+    {
+        out.mCull.push_back(cull);
+    }
+    else
+    {
+        BadValues(f, report);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract a map zone. (Name, Type, X1, Y1, Z1, X2, Y2, Z2, Level)
+*/
+void ParseZone(const Fields & f, Sections & out, const Reporter & report)
+{
+    MapZone zone{};
+    // Attempt to add this zone to the list
+    if (f.Get(1, zone.mType) && f.Get(2, zone.mMin, 3) && f.Get(5, zone.mMax, 3) &&
+        f.Get(8, zone.mLevel))
+    {
+        zone.mName = f.Str(0);
+        out.mZone.push_back(std::move(zone));
+    }
+    else
+    {
+        BadValues(f, report);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract a pickup. (ID, PosX, PosY, PosZ)
+*/
+void ParsePick(const Fields & f, Sections & out, const Reporter & report)
+{
+    Pickup pick{};
+    // Attempt to add this pickup to the list
+    if (f.Get(0, pick.mID) && f.Get(1, pick.mX) && f.Get(2, pick.mY) && f.Get(3, pick.mZ))
+    {
+        out.mPick.push_back(pick);
+    }
+    else
+    {
+        BadValues(f, report);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract a path group (Type, ModelID, ...) or a node of the last group (NodeType, NextNode,
+ * IsCrossRoad, X, Y, Z, Median, LeftLanes, RightLanes, SpeedLimit, Flags, SpawnRate).
+*/
+void ParsePath(const Fields & f, Sections & out, const Reporter & report)
+{
+    const char c = f.mData[f.mLine.mBeg[0]];
+    // Does this line start a new group?
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+    {
+        PathGroup group{f.Str(0), -1, out.mPathNodes.size(), 0};
+        // Attempt to add this group to the list
+        if (f.Get(1, group.mModel))
+        {
+            out.mPathGroups.push_back(std::move(group));
+        }
+        else
+        {
+            BadValues(f, report);
+        }
+        // We're done here
+        return;
+    }
+    // Nodes must have at least their position and lanes
+    else if (f.mLine.mCount < 9)
+    {
+        report(Category::Tokens, "Wrong number of tokens at line", f.Number());
+        // We're done here
+        return;
+    }
+    // Nodes must belong to a group
+    else if (out.mPathGroups.empty())
+    {
+        report(Category::Values, "Path node outside of a group at line", f.Number());
+        // We're done here
+        return;
+    }
+    PathNode node{};
+    // Attempt to add this node to the last group
+    if (f.Get(0, node.mType) && f.Get(1, node.mNext) && f.Get(2, node.mCross) &&
+        f.Get(3, node.mX) && f.Get(4, node.mY) && f.Get(5, node.mZ) && f.Get(6, node.mMedian) &&
+        f.Get(7, node.mLeft) && f.Get(8, node.mRight) && f.Get(9, node.mSpeed) &&
+        f.Get(10, node.mFlags) && f.Get(11, node.mSpawn))
+    {
+        out.mPathNodes.push_back(node);
+        ++out.mPathGroups.back().mCount;
+    }
+    else
+    {
+        BadValues(f, report);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract an occluder. (MidX, MidY, BottomZ, WidthX, WidthY, Height, Rotation)
+*/
+void ParseOccl(const Fields & f, Sections & out, const Reporter & report)
+{
+    Occluder occl{};
+    // Attempt to add this occluder to the list
+    if (f.Get(0, occl.mX) && f.Get(1, occl.mY) && f.Get(2, occl.mZ) &&
+        f.Get(3, occl.mWidth) && f.Get(4, occl.mLength) && f.Get(5, occl.mHeight) &&
+        f.Get(6, occl.mRotation))
+    {
+        out.mOccl.push_back(occl);
+    }
+    else
+    {
+        BadValues(f, report);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Describes how the lines of a section are processed.
+*/
+struct Handler
+{
+    // --------------------------------------------------------------------------------------------
+    Section         mSection; // The section being handled
+    const char *    mName; // Marker that starts the section
+    size_t          mLength; // Length of the marker
+    size_t          mFields; // Values expected on each line, at least
+    void         (*mParse)(const Fields &, Sections &, const Reporter &); // Processes a line
+};
+
+// ------------------------------------------------------------------------------------------------
+const Handler Handlers[] = {
+    {Section::Inst, "inst", 4, 6,   &ParseInst},
+    {Section::Cull, "cull", 4, 10,  &ParseCull},
+    {Section::Zone, "zone", 4, 9,   &ParseZone},
+    {Section::Pick, "pick", 4, 4,   &ParsePick},
+    {Section::Path, "path", 4, 2,   &ParsePath},
+    {Section::Occl, "occl", 4, 7,   &ParseOccl},
+};
+
+// ------------------------------------------------------------------------------------------------
+const Handler SkipSection = {Section::Count, "", 0, 0, nullptr}; // Sections we don't care about
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the handler of the section started by the specified marker.
+*/
+const Handler & FindHandler(const char * beg, const char * end, unsigned wanted)
+{
+    for (const auto & h : Handlers)
+    {
+        if (IsMarker(beg, end, h.mName, h.mLength))
+        {
+            return (wanted & SectionBit(h.mSection)) ? h : SkipSection;
+        }
+    }
+    // Nobody handles this section
+    return SkipSection;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the entries of every wanted section from IPL data. When there is a sink, the instances
+ * are handed to it whenever at least `batch` of them were collected, and once more at the end.
+ * The contents of the file that were already handed over are then discarded, if there's a file.
+*/
+bool Process(const char * data, size_t size, Sections & out, const Reporter & report,
+                const Progress & progress, Timings * timings, unsigned wanted, size_t batch,
+                const Sink * sink, const MappedFile * file)
+{
+    // Lines are located in bulk before their values are converted
+    static const size_t BatchSize = 256;
+    // Locates the lines and the values within them
+    Scanner scanner(data, size);
+    // The lines located in the current batch
+    Scanner::Line lines[BatchSize];
+    // The section we are in, if any
+    const Handler * section = nullptr;
+    // Time spent locating lines and converting values
+    Stopwatch watch;
+    double tokenize = 0.0, convert = 0.0;
+    // The entries that were already in the lists
+    size_t existing[static_cast< size_t >(Section::Count)];
+    for (size_t i = 0; i < static_cast< size_t >(Section::Count); ++i)
+    {
+        existing[i] = out.Count(static_cast< Section >(i));
+    }
+    // Instances that were handed to the sink and the contents they came from
+    size_t handed = 0, discarded = 0;
+    // Process the data one batch of lines at a time
+    for (size_t count = scanner.Next(lines, BatchSize); count > 0;
+                                                    count = scanner.Next(lines, BatchSize))
+    {
+        // Everything since the last lap was spent locating this batch
+        tokenize += watch.Lap();
+        // Let the caller know how far we got and whether we should continue
+        if (progress && !progress(lines[0].mBeg[0], size))
+        {
+            return false; // Cancelled!
+        }
+        // Process the lines from this batch
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Scanner::Line & line = lines[i];
+            // Where the first value starts and ends
+            const char * beg = data + line.mBeg[0], * end = data + line.mEnd[0];
+            // Is this line a comment?
+            if (*beg == '#')
+            {
+                continue; // Nothing to process here!
+            }
+            // Are we outside of a section?
+            else if (section == nullptr)
+            {
+                // Does this line start a section?
+                if (line.mCount == 1)
+                {
+                    section = &FindHandler(beg, end, wanted);
+                }
+                // Anything else outside of a section is ignored
+                continue;
+            }
+            // Are we leaving the section?
+            else if (line.mCount == 1 && IsMarker(beg, end, "end", 3))
+            {
+                section = nullptr;
+            }
+            // Is anybody interested in this section?
+            else if (section->mParse == nullptr)
+            {
+                continue; // Skip it!
+            }
+            // Do we even have enough values?
+            else if (line.mCount < section->mFields)
+            {
+                report(Category::Tokens, "Wrong number of tokens at line",
+                        static_cast< int >(line.mNumber));
+            }
+            // Let the section handle it
+            else
+            {
+                section->mParse(Fields{data, line}, out, report);
+            }
+        }
+        // Everything since the last lap was spent converting this batch
+        convert += watch.Lap();
+        // Hand over the instances once there are enough of them
+        if (sink && out.mInst.size() >= batch)
+        {
+            handed += out.mInst.size();
+            // Does the sink want more?
+            if (!(*sink)(out.mInst))
+            {
+                return false; // Cancelled!
+            }
+            out.mInst.clear();
+            // The contents before this batch are no longer needed
+            if (file)
+            {
+                file->Discard(discarded, lines[0].mBeg[0]);
+                discarded = lines[0].mBeg[0];
+            }
+            // Waiting for the sink does not count as any stage
+            watch.Lap();
+        }
+    }
+    // Everything since the last lap was spent looking for more lines
+    tokenize += watch.Lap();
+    // Hand over whatever is left
+    bool accepted = true;
+    if (sink && !out.mInst.empty())
+    {
+        handed += out.mInst.size();
+        accepted = (*sink)(out.mInst);
+        out.mInst.clear();
+    }
+    // Whether anything was extracted from this data
+    bool found = (handed > 0);
+    for (size_t i = 0; i < static_cast< size_t >(Section::Count); ++i)
+    {
+        found |= (out.Count(static_cast< Section >(i)) > existing[i]);
+    }
+    // Record the timings
+    if (timings)
+    {
+        timings->Add(Stage::Tokenize, tokenize);
+        timings->Add(Stage::Convert, convert);
+        timings->mBytes += size;
+        timings->mInstances += out.mInst.size() + handed -
+                                existing[static_cast< size_t >(Section::Inst)];
+    }
+    // Return whether we have anything to give to the caller, unless the sink stopped us
+    return found && accepted;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Map the specified IPL file and hand the mapping to the specified function.
+*/
+template < typename F > bool WithFile(const char * iplpath, const Reporter & report,
+                                        Timings * timings, F && fn)
+{
+    // See if a path was selected and whether its valid
+    if (!iplpath || *iplpath == '\0')
+    {
+        report(Category::File, "No IPL file selected", 0);
+        // We're done here
+        return false;
+    }
+    // Measure how long it takes to reach the contents
+    Stopwatch watch;
+    // Attempt to map the specified file
+    MappedFile iplfile(iplpath);
+    // Pages are read on demand, so most of the reading happens while tokenizing
+    if (timings)
+    {
+        timings->Add(Stage::Read, watch.Lap());
+    }
+    // See if the file could be opened
+    if (!iplfile.IsOpen())
+    {
+        report(Category::File, "Unable to open the selected file", 0);
+        // We're done here
+        return false;
+    }
+    // Process the contents in place
+    return fn(iplfile);
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+bool Extract(const char * iplpath, Instances & inst_list, const Reporter & report,
+                const Progress & progress, Timings * timings)
+{
+    Sections sections;
+    // Collect the instances straight into the list of the caller
+    sections.mInst.swap(inst_list);
+    const bool found = ExtractSections(iplpath, sections, report, progress, timings,
+                                        SectionBit(Section::Inst));
+    sections.mInst.swap(inst_list);
+    // Return whether we have anything to give to the caller, unless the progress stopped us
+    return found;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool ExtractBuffer(const char * data, size_t size, Instances & inst_list, const Reporter & report,
+                    const Progress & progress, Timings * timings)
+{
+    Sections sections;
+    // Collect the instances straight into the list of the caller
+    sections.mInst.swap(inst_list);
+    const bool found = ExtractSectionsBuffer(data, size, sections, report, progress, timings,
+                                                SectionBit(Section::Inst));
+    sections.mInst.swap(inst_list);
+    // Return whether we have anything to give to the caller, unless the progress stopped us
+    return found;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool ExtractSections(const char * iplpath, Sections & out, const Reporter & report,
+                        const Progress & progress, Timings * timings, unsigned wanted)
+{
+    return WithFile(iplpath, report, timings, [&](const MappedFile & file) {
+        return Process(file.Data(), file.Size(), out, report, progress, timings, wanted, 0,
+                        nullptr, nullptr);
+    });
+}
+
+// ------------------------------------------------------------------------------------------------
+bool ExtractSectionsBuffer(const char * data, size_t size, Sections & out,
+                            const Reporter & report, const Progress & progress, Timings * timings,
+                            unsigned wanted)
+{
+    return Process(data, size, out, report, progress, timings, wanted, 0, nullptr, nullptr);
+}
+
+// ------------------------------------------------------------------------------------------------
+bool ExtractStream(const char * iplpath, size_t batch, const Sink & sink, const Reporter & report,
+                    const Progress & progress, Timings * timings)
+{
+    return WithFile(iplpath, report, timings, [&](const MappedFile & file) {
+        Sections sections;
+        // Only the instances are handed over
+        return Process(file.Data(), file.Size(), sections, report, progress, timings,
+                        SectionBit(Section::Inst), batch ? batch : 1, &sink, &file);
+    });
+}
+
+} // Namespace:: VcMp
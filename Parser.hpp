@@ -0,0 +1,61 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+#include "Sections.hpp"
+#include "Progress.hpp"
+#include "Diagnostics.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <functional>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Receives the instances extracted so far. The sink may take the contents of the list, which is
+ * emptied afterwards either way. Returning false stops the extraction.
+*/
+typedef std::function< bool (Instances & batch) > Sink;
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the instances from the specified IPL file. The time spent in each stage is added to
+ * the timings, if any. Returns whether any instances were extracted. A parse that was cancelled
+ * through the progress returns false, even if some instances were already added to the list.
+*/
+bool Extract(const char * iplpath, Instances & inst_list, const Reporter & report,
+                const Progress & progress = Progress(), Timings * timings = nullptr);
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the instances from IPL data that is already in memory. The data is scanned in place.
+ * The progress is measured in bytes. Returns false when cancelled, just like Extract().
+*/
+bool ExtractBuffer(const char * data, size_t size, Instances & inst_list, const Reporter & report,
+                    const Progress & progress = Progress(), Timings * timings = nullptr);
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the entries of every wanted section from the specified IPL file in a single pass.
+ * Entries are appended to the list of their section. Returns whether anything was extracted.
+*/
+bool ExtractSections(const char * iplpath, Sections & out, const Reporter & report,
+                        const Progress & progress = Progress(), Timings * timings = nullptr,
+                        unsigned wanted = AllSections);
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the entries of every wanted section from IPL data that is already in memory.
+*/
+bool ExtractSectionsBuffer(const char * data, size_t size, Sections & out,
+                            const Reporter & report, const Progress & progress = Progress(),
+                            Timings * timings = nullptr, unsigned wanted = AllSections);
+
+/* ------------------------------------------------------------------------------------------------
+ * Extract the instances from the specified IPL file and hand them to the sink in batches of at
+ * least the specified size, so that the whole list never has to be kept in memory.
+*/
+bool ExtractStream(const char * iplpath, size_t batch, const Sink & sink, const Reporter & report,
+                    const Progress & progress = Progress(), Timings * timings = nullptr);
+
+} // Namespace:: VcMp
@@ -0,0 +1,15 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <functional>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Receives the progress of a lengthy operation. Returning false cancels the operation.
+*/
+typedef std::function< bool (size_t done, size_t total) > Progress;
+
+} // Namespace:: VcMp
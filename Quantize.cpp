@@ -0,0 +1,192 @@
+// ------------------------------------------------------------------------------------------------
+#include "Quantize.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define VCMP_QUANTIZE_X86
+    #define VCMP_TARGET(isa) __attribute__((target(isa)))
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define VCMP_QUANTIZE_X86
+    #define VCMP_TARGET(isa)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * Quantize an array of coordinates.
+*/
+typedef void (*Quantizer)(const double * src, size_t n, int32_t * dst);
+
+/* ------------------------------------------------------------------------------------------------
+ * Portable quantization kernel.
+*/
+void QuantizeScalar(const double * src, size_t n, int32_t * dst)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        dst[i] = Quantize(src[i]);
+    }
+}
+
+#ifdef VCMP_QUANTIZE_X86
+
+/* ------------------------------------------------------------------------------------------------
+ * Quantization kernel that processes 2 values at a time. SSE2 can't round down, so the value is
+ * rounded through the 2^52 trick and stepped down where that went up. Values that large are
+ * already integers and are kept as they are, which also keeps NaN around for the conversion.
+*/
+VCMP_TARGET("sse2") void QuantizeSSE2(const double * src, size_t n, int32_t * dst)
+{
+    const __m128d ten = _mm_set1_pd(10.0), half = _mm_set1_pd(0.5), one = _mm_set1_pd(1.0);
+    const __m128d sign = _mm_set1_pd(-0.0), big = _mm_set1_pd(4503599627370496.0);
+    size_t i = 0;
+    // Process 2 values at a time
+    for (; i + 2 <= n; i += 2)
+    {
+        const __m128d v = _mm_mul_pd(_mm_loadu_pd(src + i), ten);
+        const __m128d mag = _mm_andnot_pd(sign, v);
+        // Round the magnitude to the nearest integer and put the sign back
+        __m128d r = _mm_sub_pd(_mm_add_pd(mag, big), big);
+        r = _mm_or_pd(r, _mm_and_pd(v, sign));
+        // Step down where rounding went up
+        r = _mm_sub_pd(r, _mm_and_pd(_mm_cmpgt_pd(r, v), one));
+        // Keep the values that were already integers
+        const __m128d small = _mm_cmplt_pd(mag, big);
+        r = _mm_or_pd(_mm_and_pd(small, r), _mm_andnot_pd(small, v));
+        // Convert with truncation, exactly like the cast
+        _mm_storel_epi64(reinterpret_cast< __m128i * >(dst + i),
+                            _mm_cvttpd_epi32(_mm_add_pd(r, half)));
+    }
+    // Process the remaining value
+    QuantizeScalar(src + i, n - i, dst + i);
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Quantization kernel that processes 8 values at a time.
+*/
+VCMP_TARGET("avx2") void QuantizeAVX2(const double * src, size_t n, int32_t * dst)
+{
+    const __m256d ten = _mm256_set1_pd(10.0), half = _mm256_set1_pd(0.5);
+    size_t i = 0;
+    // Process 8 values at a time
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256d a = _mm256_floor_pd(_mm256_mul_pd(_mm256_loadu_pd(src + i), ten));
+        const __m256d b = _mm256_floor_pd(_mm256_mul_pd(_mm256_loadu_pd(src + i + 4), ten));
+        // Convert with truncation, exactly like the cast
+        const __m128i qa = _mm256_cvttpd_epi32(_mm256_add_pd(a, half));
+        const __m128i qb = _mm256_cvttpd_epi32(_mm256_add_pd(b, half));
+        _mm256_storeu_si256(reinterpret_cast< __m256i * >(dst + i),
+                            _mm256_inserti128_si256(_mm256_castsi128_si256(qa), qb, 1));
+    }
+    // Process the remaining values
+    QuantizeScalar(src + i, n - i, dst + i);
+}
+
+#endif // VCMP_QUANTIZE_X86
+
+/* ------------------------------------------------------------------------------------------------
+ * A quantization kernel and its name.
+*/
+struct KernelInfo
+{
+    // --------------------------------------------------------------------------------------------
+    Quantizer       mFn; // The kernel function
+    const char *    mName; // The kernel name
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Pick the widest kernel supported by the CPU.
+*/
+KernelInfo SelectKernel()
+{
+#if defined(VCMP_QUANTIZE_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    // Look for the widest supported instruction set
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return {&QuantizeAVX2, "avx2"};
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        return {&QuantizeSSE2, "sse2"};
+    }
+#elif defined(VCMP_QUANTIZE_X86)
+    int info[4];
+    __cpuid(info, 1);
+    // AVX2 also needs the OS to preserve the wide registers
+    const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+    {
+        __cpuidex(info, 7, 0);
+        // Look for the extended feature bit
+        if ((info[1] & (1 << 5)) != 0)
+        {
+            return {&QuantizeAVX2, "avx2"};
+        }
+    }
+    if (sse2)
+    {
+        return {&QuantizeSSE2, "sse2"};
+    }
+#endif
+    // Nothing better is available
+    return {&QuantizeScalar, "scalar"};
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the kernel selected for this CPU.
+*/
+const KernelInfo & Selected()
+{
+    static const KernelInfo k = SelectKernel();
+    // Return the selected kernel
+    return k;
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+void QuantizeValues(const double * src, size_t n, int32_t * dst)
+{
+    Selected().mFn(src, n, dst);
+}
+
+// ------------------------------------------------------------------------------------------------
+void QuantizePositions(const Instance * inst_list, size_t n, int32_t * dst)
+{
+    const Quantizer quantize = Selected().mFn;
+    // The positions are laid out next to each other so the kernel can load them in one go
+    double pos[QuantizeBlock * 3];
+    // Process one block of instances at a time
+    for (size_t base = 0; base < n; base += QuantizeBlock)
+    {
+        const size_t count = std::min(QuantizeBlock, n - base);
+        // Collect the positions of this block
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Instance & inst = inst_list[base + i];
+            pos[i * 3] = inst.mX, pos[i * 3 + 1] = inst.mY, pos[i * 3 + 2] = inst.mZ;
+        }
+        quantize(pos, count * 3, dst + base * 3);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+const char * QuantizeKernel()
+{
+    return Selected().mName;
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,33 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+static constexpr size_t QuantizeBlock = 256; // Instances quantized at once by the output stages
+
+/* ------------------------------------------------------------------------------------------------
+ * Quantize a whole array of coordinates. Every value comes out exactly like Quantize() would
+ * produce it, only several of them are computed at once where the CPU supports it.
+*/
+void QuantizeValues(const double * src, size_t n, int32_t * dst);
+
+/* ------------------------------------------------------------------------------------------------
+ * Quantize the positions of the specified instances. The destination receives the x, y and z
+ * of every instance one after the other, so it must hold 3 values per instance.
+*/
+void QuantizePositions(const Instance * inst_list, size_t n, int32_t * dst);
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the name of the kernel used to quantize coordinates.
+*/
+const char * QuantizeKernel();
+
+} // Namespace:: VcMp
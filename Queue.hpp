@@ -0,0 +1,124 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <deque>
+#include <mutex>
+#include <cstddef>
+#include <condition_variable>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Hands items from one thread to another in order. The number of waiting items is bounded, so a
+ * producer that gets ahead has to wait for the consumer instead of piling up memory. Closing the
+ * queue wakes everyone up: producers can no longer add items and consumers receive whatever is
+ * left before being told that nothing else will come.
+*/
+template < typename T > class Queue
+{
+private:
+
+    // --------------------------------------------------------------------------------------------
+    std::mutex              m_Mutex; // Guards everything below
+    std::condition_variable m_NotFull; // Signaled when an item is taken out
+    std::condition_variable m_NotEmpty; // Signaled when an item is added
+    std::deque< T >         m_Items; // Waiting items
+    size_t                  m_Capacity; // Maximum number of waiting items
+    bool                    m_Closed; // Whether no more items will be added
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor. Holds up to the specified number of items.
+    */
+    explicit Queue(size_t capacity)
+        : m_Mutex(), m_NotFull(), m_NotEmpty(), m_Items()
+        , m_Capacity(capacity ? capacity : 1), m_Closed(false)
+    {
+        /* ... */
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy constructor. (disabled)
+    */
+    Queue(const Queue &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy assignment operator. (disabled)
+    */
+    Queue & operator = (const Queue &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Add an item, waiting for room if necessary. Returns false if the queue was closed.
+    */
+    bool Push(T && item)
+    {
+        std::unique_lock< std::mutex > lock(m_Mutex);
+        // Wait until there is room or nobody cares anymore
+        m_NotFull.wait(lock, [this]() { return m_Closed || m_Items.size() < m_Capacity; });
+        // Is anyone still taking items out?
+        if (m_Closed)
+        {
+            return false;
+        }
+        m_Items.push_back(std::move(item));
+        lock.unlock();
+        // Wake up the consumer
+        m_NotEmpty.notify_one();
+        // The item was added
+        return true;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Take out the next item, waiting for one if necessary. Returns false once the queue was
+     * closed and every item was taken out.
+    */
+    bool Pop(T & item)
+    {
+        std::unique_lock< std::mutex > lock(m_Mutex);
+        // Wait until there is an item or nothing else will come
+        m_NotEmpty.wait(lock, [this]() { return m_Closed || !m_Items.empty(); });
+        // Is this the end?
+        if (m_Items.empty())
+        {
+            return false;
+        }
+        item = std::move(m_Items.front());
+        m_Items.pop_front();
+        lock.unlock();
+        // Wake up the producer
+        m_NotFull.notify_one();
+        // An item was taken out
+        return true;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Stop accepting items and wake up everyone who is waiting.
+    */
+    void Close()
+    {
+        {
+            std::lock_guard< std::mutex > lock(m_Mutex);
+            m_Closed = true;
+        }
+        m_NotFull.notify_all();
+        m_NotEmpty.notify_all();
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Stop accepting items and drop the waiting ones, so that the consumer stops as well.
+    */
+    void Cancel()
+    {
+        {
+            std::lock_guard< std::mutex > lock(m_Mutex);
+            m_Closed = true;
+            m_Items.clear();
+        }
+        m_NotFull.notify_all();
+        m_NotEmpty.notify_all();
+    }
+};
+
+} // Namespace:: VcMp
@@ -0,0 +1,309 @@
+// ------------------------------------------------------------------------------------------------
+#include "Scanner.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstring>
+
+// ------------------------------------------------------------------------------------------------
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define VCMP_SCAN_X86
+    #define VCMP_TARGET(isa) __attribute__((target(isa)))
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define VCMP_SCAN_X86
+    #define VCMP_TARGET(isa)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * Classify 64 bytes into a mask of separators (spaces and commas) and a mask of line breaks.
+*/
+typedef void (*Classifier)(const char * p, uint64_t & sep, uint64_t & brk);
+
+/* ------------------------------------------------------------------------------------------------
+ * Portable classification kernel.
+*/
+void ClassifyScalar(const char * p, uint64_t & sep, uint64_t & brk)
+{
+    sep = 0, brk = 0;
+    // Process one byte at a time
+    for (unsigned i = 0; i < 64; ++i)
+    {
+        const unsigned char c = static_cast< unsigned char >(p[i]);
+        // Characters from '\t' to '\r' are no further than 4 from '\t'
+        const bool ctl = static_cast< unsigned >(c - '\t') <= 4u;
+        // Is this a comma, a space or any of the characters from '\t' to '\r'?
+        sep |= static_cast< uint64_t >(c == ',' || c == ' ' || ctl) << i;
+        brk |= static_cast< uint64_t >(c == '\n') << i;
+    }
+}
+
+#ifdef VCMP_SCAN_X86
+
+/* ------------------------------------------------------------------------------------------------
+ * Classification kernel that processes 16 bytes at a time.
+*/
+VCMP_TARGET("sse2") void ClassifySSE2(const char * p, uint64_t & sep, uint64_t & brk)
+{
+    const __m128i comma = _mm_set1_epi8(','), space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t'), line = _mm_set1_epi8('\n'), four = _mm_set1_epi8(4);
+    sep = 0, brk = 0;
+    // Process 16 bytes at a time
+    for (unsigned i = 0; i < 64; i += 16)
+    {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast< const __m128i * >(p + i));
+        // Characters from '\t' to '\r' are no further than 4 from '\t'
+        const __m128i r = _mm_sub_epi8(c, tab);
+        const __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(r, four), r);
+        // Combine with commas and spaces
+        const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, comma),
+                                                    _mm_cmpeq_epi8(c, space)), ctl);
+        // Store the resulted bits
+        sep |= static_cast< uint64_t >(static_cast< uint32_t >(_mm_movemask_epi8(m))) << i;
+        brk |= static_cast< uint64_t >(static_cast< uint32_t >(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(c, line)))) << i;
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Classification kernel that processes 32 bytes at a time.
+*/
+VCMP_TARGET("avx2") void ClassifyAVX2(const char * p, uint64_t & sep, uint64_t & brk)
+{
+    const __m256i comma = _mm256_set1_epi8(','), space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t'), line = _mm256_set1_epi8('\n');
+    const __m256i four = _mm256_set1_epi8(4);
+    sep = 0, brk = 0;
+    // Process 32 bytes at a time
+    for (unsigned i = 0; i < 64; i += 32)
+    {
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(p + i));
+        // Characters from '\t' to '\r' are no further than 4 from '\t'
+        const __m256i r = _mm256_sub_epi8(c, tab);
+        const __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(r, four), r);
+        // Combine with commas and spaces
+        const __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(c, comma),
+                                                            _mm256_cmpeq_epi8(c, space)), ctl);
+        // Store the resulted bits
+        sep |= static_cast< uint64_t >(static_cast< uint32_t >(_mm256_movemask_epi8(m))) << i;
+        brk |= static_cast< uint64_t >(static_cast< uint32_t >(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(c, line)))) << i;
+    }
+}
+
+#endif // VCMP_SCAN_X86
+
+/* ------------------------------------------------------------------------------------------------
+ * A classification kernel and its name.
+*/
+struct KernelInfo
+{
+    // --------------------------------------------------------------------------------------------
+    Classifier      mFn; // The kernel function
+    const char *    mName; // The kernel name
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Pick the widest kernel supported by the CPU.
+*/
+KernelInfo SelectKernel()
+{
+#if defined(VCMP_SCAN_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    // Look for the widest supported instruction set
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return {&ClassifyAVX2, "avx2"};
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        return {&ClassifySSE2, "sse2"};
+    }
+#elif defined(VCMP_SCAN_X86)
+    int info[4];
+    __cpuid(info, 1);
+    // AVX2 also needs the OS to preserve the wide registers
+    const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+    {
+        __cpuidex(info, 7, 0);
+        // Look for the extended feature bit
+        if ((info[1] & (1 << 5)) != 0)
+        {
+            return {&ClassifyAVX2, "avx2"};
+        }
+    }
+    if (sse2)
+    {
+        return {&ClassifySSE2, "sse2"};
+    }
+#endif
+    // Nothing better is available
+    return {&ClassifyScalar, "scalar"};
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the kernel selected for this CPU.
+*/
+const KernelInfo & Selected()
+{
+    static const KernelInfo k = SelectKernel();
+    // Return the selected kernel
+    return k;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the index of the lowest set bit in a non-zero mask.
+*/
+inline unsigned LowestBit(uint64_t m)
+{
+#if defined(__GNUC__)
+    return static_cast< unsigned >(__builtin_ctzll(m));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanForward64(&idx, m);
+    return static_cast< unsigned >(idx);
+#else
+    unsigned idx = 0;
+    while ((m & 1) == 0)
+    {
+        m >>= 1, ++idx;
+    }
+    return idx;
+#endif
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+Scanner::Scanner(const char * data, size_t size)
+    : m_Data(data), m_Size(size), m_Chunk(0)
+    , m_Starts(0), m_Ends(0), m_Breaks(0), m_Carry(1)
+    , m_Line(), m_Open(false)
+{
+    m_Line.mNumber = 1;
+}
+
+// ------------------------------------------------------------------------------------------------
+const char * Scanner::Kernel()
+{
+    return Selected().mName;
+}
+
+// ------------------------------------------------------------------------------------------------
+void Scanner::Load()
+{
+    // Where the chunk starts and how much data is left
+    const char * p = m_Data + m_Chunk;
+    const size_t rem = m_Size - m_Chunk;
+    // Storage for the last chunk when it is incomplete
+    char tail[64];
+    // Is there enough data left for a whole chunk?
+    if (rem < sizeof(tail))
+    {
+        std::memcpy(tail, p, rem);
+        // Pad with line breaks so the last line is terminated
+        std::memset(tail + rem, '\n', sizeof(tail) - rem);
+        // Classify the padded copy instead
+        p = tail;
+    }
+    // Classify the chunk
+    uint64_t sep, brk;
+    Selected().mFn(p, sep, brk);
+    // Values start after a separator and end at a separator
+    m_Starts = ~sep & ((sep << 1) | m_Carry);
+    m_Ends = sep & ((~sep << 1) | (m_Carry ^ 1));
+    m_Breaks = brk;
+    // Remember how the chunk ended for the next one
+    m_Carry = sep >> 63;
+    // Move to the next chunk
+    m_Chunk += sizeof(tail);
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t Scanner::Next(Line * lines, size_t max)
+{
+    size_t n = 0;
+    // Keep going until the output is full
+    while (n < max)
+    {
+        // Every event in a chunk
+        const uint64_t events = m_Starts | m_Ends | m_Breaks;
+        // Is the current chunk exhausted?
+        if (events == 0)
+        {
+            // Is there another chunk?
+            if (m_Chunk < m_Size)
+            {
+                Load();
+                // Walk the new chunk
+                continue;
+            }
+            // Terminate the last line if it did not end with a line break
+            if (m_Open)
+            {
+                m_Line.mEnd[m_Line.mCount++] = m_Size;
+                m_Open = false;
+            }
+            // Is there a last line to give?
+            if (m_Line.mCount > 0)
+            {
+                lines[n++] = m_Line;
+                m_Line.mCount = 0;
+            }
+            // Nothing left to scan
+            break;
+        }
+        // Locate the next event
+        const unsigned bit = LowestBit(events);
+        const uint64_t mask = static_cast< uint64_t >(1) << bit;
+        const size_t pos = m_Chunk - 64 + bit;
+        // Does a value end here?
+        if (m_Ends & mask)
+        {
+            m_Ends ^= mask;
+            // Only values that were recorded have to be terminated
+            if (m_Open)
+            {
+                m_Line.mEnd[m_Line.mCount++] = pos;
+                m_Open = false;
+            }
+        }
+        // Does the line end here?
+        if (m_Breaks & mask)
+        {
+            m_Breaks ^= mask;
+            // Only lines with values are given to the caller
+            if (m_Line.mCount > 0)
+            {
+                lines[n++] = m_Line;
+                m_Line.mCount = 0;
+            }
+            // Advance the line count
+            ++m_Line.mNumber;
+        }
+        // Does a value start here?
+        if (m_Starts & mask)
+        {
+            m_Starts ^= mask;
+            // Values past the ones we care about are ignored
+            if (m_Line.mCount < MaxFields)
+            {
+                m_Line.mBeg[m_Line.mCount] = pos;
+                m_Open = true;
+            }
+        }
+    }
+    // Return how many lines were produced
+    return n;
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,72 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Locates the lines of IPL data and the values within them. The data is classified 64 bytes at a
+ * time into bit masks of separators and line breaks with the widest kernel supported by the CPU,
+ * then the masks are walked to produce the field offsets of many lines at once.
+*/
+class Scanner
+{
+public:
+
+    // --------------------------------------------------------------------------------------------
+    static const size_t MaxFields = 12; // Fields recorded per line (the rest are dropped)
+
+    /* --------------------------------------------------------------------------------------------
+     * A line that has at least one value in it.
+    */
+    struct Line
+    {
+        // ----------------------------------------------------------------------------------------
+        size_t  mNumber; // Line number (starting from 1)
+        size_t  mCount; // Number of values (no more than MaxFields)
+        size_t  mBeg[MaxFields]; // Offset of the first character of each value
+        size_t  mEnd[MaxFields]; // Offset one past the last character of each value
+    };
+
+private:
+
+    // --------------------------------------------------------------------------------------------
+    const char *    m_Data; // Data being scanned
+    size_t          m_Size; // Size of the scanned data
+    size_t          m_Chunk; // Offset of the chunk being walked
+    uint64_t        m_Starts; // Remaining value starts in the current chunk
+    uint64_t        m_Ends; // Remaining value ends in the current chunk
+    uint64_t        m_Breaks; // Remaining line breaks in the current chunk
+    uint64_t        m_Carry; // Whether the last byte of the previous chunk was a separator
+    Line            m_Line; // The line being assembled
+    bool            m_Open; // Whether a value was started and not yet ended
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor.
+    */
+    Scanner(const char * data, size_t size);
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the next lines that have values in them. Returns 0 once the data is exhausted.
+    */
+    size_t Next(Line * lines, size_t max);
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the name of the classification kernel selected for this CPU.
+    */
+    static const char * Kernel();
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * Classify the next chunk of data and reset the masks that are walked.
+    */
+    void Load();
+};
+
+} // Namespace:: VcMp
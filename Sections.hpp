@@ -0,0 +1,182 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * The sections of an IPL file that are understood.
+*/
+enum class Section
+{
+    Inst = 0, // Object instances
+    Cull, // Culling zones
+    Zone, // Map zones
+    Pick, // Pickups
+    Path, // Path groups and their nodes
+    Occl, // Occluders
+    // --------------------------------------------------------------------------------------------
+    Count
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the bit that selects the specified section in a mask.
+*/
+inline unsigned SectionBit(Section sec)
+{
+    return 1u << static_cast< unsigned >(sec);
+}
+
+// ------------------------------------------------------------------------------------------------
+static const unsigned AllSections = (1u << static_cast< unsigned >(Section::Count)) - 1;
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the name of the specified section, as written in the file.
+*/
+inline const char * SectionName(Section sec)
+{
+    switch (sec)
+    {
+        case Section::Inst: return "inst";
+        case Section::Cull: return "cull";
+        case Section::Zone: return "zone";
+        case Section::Pick: return "pick";
+        case Section::Path: return "path";
+        case Section::Occl: return "occl";
+        default: return "unknown";
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * A culling zone. (cull)
+*/
+struct CullZone
+{
+    // --------------------------------------------------------------------------------------------
+    double  mCenter[3]; // Center of the zone
+    double  mMin[3]; // Lower corner of the zone
+    double  mMax[3]; // Upper corner of the zone
+    int     mFlags; // Zone attributes
+    int     mWanted; // Wanted level drop (0 when not specified)
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * A map zone. (zone)
+*/
+struct MapZone
+{
+    // --------------------------------------------------------------------------------------------
+    std::string mName; // Zone name
+    int         mType; // Zone type
+    double      mMin[3]; // First corner of the zone
+    double      mMax[3]; // Second corner of the zone
+    int         mLevel; // Island the zone belongs to
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * A pickup. (pick)
+*/
+struct Pickup
+{
+    // --------------------------------------------------------------------------------------------
+    int     mID; // Pickup identifier
+    double  mX, mY, mZ; // Pickup position
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * A group of path nodes that belongs to a model. (path)
+*/
+struct PathGroup
+{
+    // --------------------------------------------------------------------------------------------
+    std::string mType; // Kind of path (ped or car)
+    int         mModel; // Model the nodes belong to (-1 for none)
+    size_t      mFirst; // Index of the first node of the group
+    size_t      mCount; // Number of nodes in the group
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * A path node. Values are kept as written, relative to the model of the group. (path)
+*/
+struct PathNode
+{
+    // --------------------------------------------------------------------------------------------
+    int     mType; // Node type (0 for unused nodes)
+    int     mNext; // Index of the connected node
+    int     mCross; // Whether this is a cross road
+    double  mX, mY, mZ; // Node position
+    double  mMedian; // Width of the median
+    int     mLeft, mRight; // Number of lanes on each side
+    int     mSpeed; // Speed limit (0 when not specified)
+    int     mFlags; // Node attributes (0 when not specified)
+    double  mSpawn; // Spawn rate (0 when not specified)
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * An occluder. (occl)
+*/
+struct Occluder
+{
+    // --------------------------------------------------------------------------------------------
+    double  mX, mY; // Middle of the occluder
+    double  mZ; // Bottom of the occluder
+    double  mWidth, mLength, mHeight; // Size of the occluder
+    double  mRotation; // Rotation around the vertical axis
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Everything extracted from IPL files, one list per section in the order of the files.
+*/
+struct Sections
+{
+    // --------------------------------------------------------------------------------------------
+    Instances                   mInst; // Object instances
+    std::vector< CullZone >     mCull; // Culling zones
+    std::vector< MapZone >      mZone; // Map zones
+    std::vector< Pickup >       mPick; // Pickups
+    std::vector< PathGroup >    mPathGroups; // Path groups
+    std::vector< PathNode >     mPathNodes; // Nodes of every path group
+    std::vector< Occluder >     mOccl; // Occluders
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of entries in the specified section.
+    */
+    size_t Count(Section sec) const
+    {
+        switch (sec)
+        {
+            case Section::Inst: return mInst.size();
+            case Section::Cull: return mCull.size();
+            case Section::Zone: return mZone.size();
+            case Section::Pick: return mPick.size();
+            case Section::Path: return mPathNodes.size();
+            case Section::Occl: return mOccl.size();
+            default: return 0;
+        }
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Remove every entry.
+    */
+    void Clear()
+    {
+        mInst.clear();
+        mCull.clear();
+        mZone.clear();
+        mPick.clear();
+        mPathGroups.clear();
+        mPathNodes.clear();
+        mOccl.clear();
+    }
+};
+
+} // Namespace:: VcMp
@@ -0,0 +1,349 @@
+// ------------------------------------------------------------------------------------------------
+#include "SpatialIndex.hpp"
+#include "MappedFile.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// ------------------------------------------------------------------------------------------------
+#include <limits>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+const char      IndexMagic[8] = {'I', 'P', 'L', 'H', 'I', 'D', 'X', '\0'}; // File signature
+const uint32_t  IndexVersion = 1; // File format version
+
+/* ------------------------------------------------------------------------------------------------
+ * Fixed portion at the start of an index file. Everything is stored in native byte order.
+*/
+struct IndexHeader
+{
+    // --------------------------------------------------------------------------------------------
+    char        mMagic[8]; // File signature
+    uint32_t    mVersion; // File format version
+    uint32_t    mNX, mNY; // Number of cells along each axis
+    uint32_t    mCount; // Number of instances
+    double      mMinX, mMinY; // Lowest corner of the grid
+    double      mCellSize; // Size of each cell
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * An instance as stored in an index file.
+*/
+struct IndexRecord
+{
+    // --------------------------------------------------------------------------------------------
+    int32_t     mID; // Model identifier
+    uint32_t    mOrder; // Position in the original list
+    double      mX, mY, mZ; // Model position
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Write the specified values to a file.
+*/
+template < typename T > bool WriteAll(std::FILE * file, const T * data, size_t count)
+{
+    return std::fwrite(data, sizeof(T), count, file) == count;
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+SpatialIndex::SpatialIndex()
+    : m_MinX(0.0), m_MinY(0.0), m_CellSize(1.0), m_NX(1), m_NY(1)
+    , m_Cells(2, 0), m_Items(), m_Order(), m_Models()
+{
+    /* ... */
+}
+
+// ------------------------------------------------------------------------------------------------
+uint32_t SpatialIndex::Cell(double v, double min, uint32_t count) const
+{
+    const double c = std::floor((v - min) / m_CellSize);
+    // Values outside the grid (or not a number) belong to the nearest edge
+    if (!(c >= 0.0))
+    {
+        return 0;
+    }
+    return c < count ? static_cast< uint32_t >(c) : count - 1;
+}
+
+// ------------------------------------------------------------------------------------------------
+void SpatialIndex::Build(const Instances & inst_list, double cell_size)
+{
+    // Find the area covered by the instances
+    double min_x = std::numeric_limits< double >::max(), max_x = -min_x;
+    double min_y = min_x, max_y = max_x;
+    for (const auto & inst : inst_list)
+    {
+        // Ignore coordinates that cannot be placed on a grid
+        if (std::isfinite(inst.mX) && std::isfinite(inst.mY))
+        {
+            min_x = std::min(min_x, inst.mX), max_x = std::max(max_x, inst.mX);
+            min_y = std::min(min_y, inst.mY), max_y = std::max(max_y, inst.mY);
+        }
+    }
+    // Was anything found?
+    if (min_x > max_x)
+    {
+        min_x = max_x = min_y = max_y = 0.0;
+    }
+    // Use larger cells if the area would need too many of them
+    const double extent = std::max(max_x - min_x, max_y - min_y);
+    m_CellSize = std::max(cell_size > 0.0 ? cell_size : 1.0, extent / (MaxCells - 1));
+    // Compute the grid dimensions
+    m_MinX = min_x, m_MinY = min_y;
+    m_NX = static_cast< uint32_t >((max_x - min_x) / m_CellSize) + 1;
+    m_NY = static_cast< uint32_t >((max_y - min_y) / m_CellSize) + 1;
+    // Find the cell of every instance and count how many go in each cell
+    std::vector< uint32_t > cells(inst_list.size());
+    m_Cells.assign(static_cast< size_t >(m_NX) * m_NY + 1, 0);
+    for (size_t i = 0; i < inst_list.size(); ++i)
+    {
+        const Instance & inst = inst_list[i];
+        // Compute the cell index
+        cells[i] = Cell(inst.mY, m_MinY, m_NY) * m_NX + Cell(inst.mX, m_MinX, m_NX);
+        // Count the instance in that cell
+        ++m_Cells[cells[i] + 1];
+    }
+    // Turn the counts into offsets
+    for (size_t i = 1; i < m_Cells.size(); ++i)
+    {
+        m_Cells[i] += m_Cells[i - 1];
+    }
+    // Place every instance in its cell while keeping their relative order
+    std::vector< uint32_t > next(m_Cells.begin(), m_Cells.end() - 1);
+    m_Items.assign(inst_list.size(), Instance(0, 0.0, 0.0, 0.0));
+    m_Order.assign(inst_list.size(), 0);
+    for (size_t i = 0; i < inst_list.size(); ++i)
+    {
+        const uint32_t pos = next[cells[i]]++;
+        // Store the instance and where it came from
+        m_Items[pos] = inst_list[i];
+        m_Order[pos] = static_cast< uint32_t >(i);
+    }
+    // Build the model lookup
+    SortModels();
+}
+
+// ------------------------------------------------------------------------------------------------
+void SpatialIndex::SortModels()
+{
+    m_Models.resize(m_Items.size());
+    // Start with the instances in their original order
+    for (size_t i = 0; i < m_Items.size(); ++i)
+    {
+        m_Models[m_Order[i]] = static_cast< uint32_t >(i);
+    }
+    // Group them by model while keeping their original order
+    std::stable_sort(m_Models.begin(), m_Models.end(), [this](uint32_t a, uint32_t b) {
+        return m_Items[a].mID < m_Items[b].mID;
+    });
+}
+
+// ------------------------------------------------------------------------------------------------
+bool SpatialIndex::Save(const char * path) const
+{
+    // Attempt to create the file
+    std::FILE * file = std::fopen(path, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    // Prepare the header
+    IndexHeader header;
+    std::memcpy(header.mMagic, IndexMagic, sizeof(IndexMagic));
+    header.mVersion = IndexVersion;
+    header.mNX = m_NX, header.mNY = m_NY;
+    header.mCount = static_cast< uint32_t >(m_Items.size());
+    header.mMinX = m_MinX, header.mMinY = m_MinY;
+    header.mCellSize = m_CellSize;
+    // Prepare the instances
+    std::vector< IndexRecord > records(m_Items.size());
+    for (size_t i = 0; i < m_Items.size(); ++i)
+    {
+        const Instance & inst = m_Items[i];
+        // Store the instance and where it came from
+        records[i] = {inst.mID, m_Order[i], inst.mX, inst.mY, inst.mZ};
+    }
+    // Write everything
+    bool ok = WriteAll(file, &header, 1) &&
+                WriteAll(file, m_Cells.data(), m_Cells.size()) &&
+                WriteAll(file, records.data(), records.size()) &&
+                WriteAll(file, m_Models.data(), m_Models.size());
+    // Make sure everything reached the file
+    ok = (std::fclose(file) == 0) && ok;
+    // Report whether the index was saved
+    return ok;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool SpatialIndex::Load(const char * path)
+{
+    MappedFile file(path);
+    // Is there enough data for the header?
+    if (!file.IsOpen() || file.Size() < sizeof(IndexHeader))
+    {
+        return false;
+    }
+    IndexHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    // Is this an index file that we understand?
+    if (std::memcmp(header.mMagic, IndexMagic, sizeof(IndexMagic)) != 0 ||
+        header.mVersion != IndexVersion || header.mNX == 0 || header.mNY == 0 ||
+        header.mNX > MaxCells || header.mNY > MaxCells || !(header.mCellSize > 0.0))
+    {
+        return false;
+    }
+    // Compute the size of each portion
+    const size_t cells = static_cast< size_t >(header.mNX) * header.mNY + 1;
+    const size_t count = header.mCount;
+    // Does the file hold everything that it should?
+    if (file.Size() != sizeof(IndexHeader) + cells * sizeof(uint32_t) +
+                        count * sizeof(IndexRecord) + count * sizeof(uint32_t))
+    {
+        return false;
+    }
+    // Where each portion starts
+    const char * data = file.Data() + sizeof(IndexHeader);
+    // Load the cell offsets
+    m_Cells.resize(cells);
+    std::memcpy(m_Cells.data(), data, cells * sizeof(uint32_t));
+    data += cells * sizeof(uint32_t);
+    // Load the instances
+    m_Items.assign(count, Instance(0, 0.0, 0.0, 0.0));
+    m_Order.resize(count);
+    for (size_t i = 0; i < count; ++i, data += sizeof(IndexRecord))
+    {
+        IndexRecord r;
+        std::memcpy(&r, data, sizeof(r));
+        // Store the instance and where it came from
+        m_Items[i] = Instance(r.mID, r.mX, r.mY, r.mZ);
+        m_Order[i] = r.mOrder;
+    }
+    // Load the model lookup
+    m_Models.resize(count);
+    std::memcpy(m_Models.data(), data, count * sizeof(uint32_t));
+    // Load the grid dimensions
+    m_MinX = header.mMinX, m_MinY = header.mMinY;
+    m_CellSize = header.mCellSize;
+    m_NX = header.mNX, m_NY = header.mNY;
+    // Make sure the offsets and lookups cannot take us outside the instances
+    return m_Cells.front() == 0 && m_Cells.back() == count &&
+            std::is_sorted(m_Cells.begin(), m_Cells.end()) &&
+            std::all_of(m_Models.begin(), m_Models.end(), [count](uint32_t i) {
+                return i < count;
+            });
+}
+
+// ------------------------------------------------------------------------------------------------
+void SpatialIndex::Find(const Query & query, Instances & out) const
+{
+    // Accepted models, sorted for quick lookups. Repeated models must only be looked up once
+    std::vector< int > models(query.mModels);
+    std::sort(models.begin(), models.end());
+    models.erase(std::unique(models.begin(), models.end()), models.end());
+    // Squared radius to avoid the square root
+    const double r2 = query.mRadius * query.mRadius;
+    // Instances that meet the conditions
+    std::vector< uint32_t > found;
+    // See whether an instance meets the conditions
+    auto accept = [&](const Instance & inst) {
+        // Is it inside the box?
+        if (query.mBox && !(inst.mX >= query.mMin[0] && inst.mX <= query.mMax[0] &&
+                            inst.mY >= query.mMin[1] && inst.mY <= query.mMax[1] &&
+                            inst.mZ >= query.mMin[2] && inst.mZ <= query.mMax[2]))
+        {
+            return false;
+        }
+        // Is it inside the sphere?
+        if (query.mSphere)
+        {
+            const double dx = inst.mX - query.mCenter[0], dy = inst.mY - query.mCenter[1];
+            const double dz = inst.mZ - query.mCenter[2];
+            // Compare the squared distance
+            if (!(dx * dx + dy * dy + dz * dz <= r2))
+            {
+                return false;
+            }
+        }
+        // Is it one of the accepted models?
+        return models.empty() || std::binary_search(models.begin(), models.end(), inst.mID);
+    };
+    // Is there a region to look in?
+    if (query.mBox || query.mSphere)
+    {
+        // Find the horizontal area covered by the conditions
+        double min_x = -std::numeric_limits< double >::infinity(), max_x = -min_x;
+        double min_y = min_x, max_y = max_x;
+        if (query.mBox)
+        {
+            min_x = query.mMin[0], max_x = query.mMax[0];
+            min_y = query.mMin[1], max_y = query.mMax[1];
+        }
+        if (query.mSphere)
+        {
+            min_x = std::max(min_x, query.mCenter[0] - query.mRadius);
+            max_x = std::min(max_x, query.mCenter[0] + query.mRadius);
+            min_y = std::max(min_y, query.mCenter[1] - query.mRadius);
+            max_y = std::min(max_y, query.mCenter[1] + query.mRadius);
+        }
+        // Visit only the cells that overlap the area
+        const uint32_t cx0 = Cell(min_x, m_MinX, m_NX), cx1 = Cell(max_x, m_MinX, m_NX);
+        const uint32_t cy0 = Cell(min_y, m_MinY, m_NY), cy1 = Cell(max_y, m_MinY, m_NY);
+        for (uint32_t cy = cy0; cy <= cy1 && min_x <= max_x && min_y <= max_y; ++cy)
+        {
+            // Instances of a row of cells are contiguous
+            const uint32_t beg = m_Cells[cy * m_NX + cx0], end = m_Cells[cy * m_NX + cx1 + 1];
+            for (uint32_t i = beg; i < end; ++i)
+            {
+                if (accept(m_Items[i]))
+                {
+                    found.push_back(i);
+                }
+            }
+        }
+    }
+    // Only models were requested
+    else if (!models.empty())
+    {
+        for (int id : models)
+        {
+            // Locate the instances of this model
+            auto beg = std::lower_bound(m_Models.begin(), m_Models.end(), id,
+                [this](uint32_t i, int v) { return m_Items[i].mID < v; });
+            auto end = std::upper_bound(beg, m_Models.end(), id,
+                [this](int v, uint32_t i) { return v < m_Items[i].mID; });
+            found.insert(found.end(), beg, end);
+        }
+    }
+    // Everything was requested
+    else
+    {
+        found.resize(m_Items.size());
+        for (size_t i = 0; i < found.size(); ++i)
+        {
+            found[i] = static_cast< uint32_t >(i);
+        }
+    }
+    // Restore the original order
+    std::sort(found.begin(), found.end(), [this](uint32_t a, uint32_t b) {
+        return m_Order[a] < m_Order[b];
+    });
+    // Give the instances to the caller
+    out.reserve(out.size() + found.size());
+    for (uint32_t i : found)
+    {
+        out.push_back(m_Items[i]);
+    }
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,106 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+
+// ------------------------------------------------------------------------------------------------
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Uniform grid over the horizontal plane that holds instances from any number of files. Instances
+ * are stored contiguously by cell so a region only visits the cells it overlaps. The index can be
+ * saved to disk and loaded later without parsing the files again.
+*/
+class SpatialIndex
+{
+public:
+
+    // --------------------------------------------------------------------------------------------
+    static const uint32_t MaxCells = 4096; // Maximum number of cells along each axis
+
+    /* --------------------------------------------------------------------------------------------
+     * Conditions that instances must meet to be found. Conditions that are not enabled are
+     * ignored and the enabled ones must all be met.
+    */
+    struct Query
+    {
+        // ----------------------------------------------------------------------------------------
+        bool                mBox = false; // Whether the instance must be inside a box
+        double              mMin[3] = {0.0, 0.0, 0.0}; // Lowest corner of the box
+        double              mMax[3] = {0.0, 0.0, 0.0}; // Highest corner of the box
+        // ----------------------------------------------------------------------------------------
+        bool                mSphere = false; // Whether the instance must be near a point
+        double              mCenter[3] = {0.0, 0.0, 0.0}; // Center of the sphere
+        double              mRadius = 0.0; // Radius of the sphere
+        // ----------------------------------------------------------------------------------------
+        std::vector< int >  mModels; // Models that are accepted (empty accepts all)
+    };
+
+private:
+
+    // --------------------------------------------------------------------------------------------
+    double                  m_MinX, m_MinY; // Lowest corner of the grid
+    double                  m_CellSize; // Size of each cell
+    uint32_t                m_NX, m_NY; // Number of cells along each axis
+    std::vector< uint32_t > m_Cells; // Where the instances of each cell start
+    Instances               m_Items; // Instances ordered by cell
+    std::vector< uint32_t > m_Order; // Position of each instance in the original list
+    std::vector< uint32_t > m_Models; // Instances ordered by model
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Default constructor. Creates an empty index.
+    */
+    SpatialIndex();
+
+    /* --------------------------------------------------------------------------------------------
+     * Build the index from the specified instances using cells of the specified size.
+    */
+    void Build(const Instances & inst_list, double cell_size);
+
+    /* --------------------------------------------------------------------------------------------
+     * Save the index to the specified file.
+    */
+    bool Save(const char * path) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Load the index from the specified file.
+    */
+    bool Load(const char * path);
+
+    /* --------------------------------------------------------------------------------------------
+     * Append the instances that meet the specified conditions to the output list, in the order
+     * in which they were given to the index.
+    */
+    void Find(const Query & query, Instances & out) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of indexed instances.
+    */
+    size_t Size() const
+    {
+        return m_Items.size();
+    }
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the cell along an axis that holds the specified coordinate.
+    */
+    uint32_t Cell(double v, double min, uint32_t count) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Build the list of instances ordered by model.
+    */
+    void SortModels();
+};
+
+} // Namespace:: VcMp
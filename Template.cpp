@@ -0,0 +1,215 @@
+// ------------------------------------------------------------------------------------------------
+#include "Template.hpp"
+#include "Quantize.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstring>
+
+// ------------------------------------------------------------------------------------------------
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+const size_t ProgressStep = 4096; // Instances generated between progress updates
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+void Template::AddText(const char * s, size_t n)
+{
+    // Can we extend the previous step?
+    if (m_Steps.empty() || m_Steps.back().mOp != Op::Text)
+    {
+        m_Steps.push_back({Op::Text, 0, static_cast< uint32_t >(m_Text.size()), 0});
+    }
+    // Store the text and include it in the step
+    m_Text.append(s, n);
+    m_Steps.back().mLen += static_cast< uint32_t >(n);
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Template::Compile(const char * pattern, const char * func, std::string & error)
+{
+    // Start from scratch
+    m_Steps.clear();
+    m_Text.clear();
+    // Process the pattern
+    for (const char * p = pattern; *p != '\0';)
+    {
+        // Is this a literal brace?
+        if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}'))
+        {
+            AddText(p, 1);
+            p += 2;
+        }
+        // Is this a placeholder?
+        else if (*p == '{')
+        {
+            const char * end = std::strchr(p, '}');
+            // Is the placeholder terminated?
+            if (end == nullptr)
+            {
+                error = "Unterminated placeholder in template";
+                // We're done here
+                return false;
+            }
+            const std::string name(p + 1, end);
+            // Move past the placeholder
+            p = end + 1;
+            // Identify the placeholder
+            if (name == "func")
+            {
+                AddText(func, std::strlen(func));
+                continue;
+            }
+            else if (name == "id")
+            {
+                m_Steps.push_back({Op::ID, 0, 0, 0});
+                continue;
+            }
+            // The remaining placeholders are coordinates
+            const size_t colon = name.find(':');
+            const std::string axis = name.substr(0, colon);
+            const std::string form = colon == std::string::npos ? "" : name.substr(colon + 1);
+            // Identify the coordinate and its form
+            Step step{Op::Fixed, 0, 0, 0};
+            if (axis == "x" || axis == "y" || axis == "z")
+            {
+                step.mAxis = static_cast< uint8_t >(axis[0] - 'x');
+            }
+            else
+            {
+                error = "Unknown template placeholder: {" + name + "}";
+                // We're done here
+                return false;
+            }
+            if (form == "raw")
+            {
+                step.mOp = Op::Raw;
+            }
+            else if (form == "short")
+            {
+                step.mOp = Op::Short;
+            }
+            else if (!form.empty() && form != "fixed")
+            {
+                error = "Unknown coordinate form in template: {" + name + "}";
+                // We're done here
+                return false;
+            }
+            m_Steps.push_back(step);
+        }
+        else if (*p == '}')
+        {
+            error = "Unmatched closing brace in template";
+            // We're done here
+            return false;
+        }
+        // Is this an escape sequence?
+        else if (*p == '\\' && (p[1] == 'n' || p[1] == 't' || p[1] == '\\'))
+        {
+            AddText(p[1] == 'n' ? "\n" : (p[1] == 't' ? "\t" : "\\"), 1);
+            p += 2;
+        }
+        // Everything up to the next special character is taken as is
+        else
+        {
+            const size_t n = std::strcspn(p + 1, "{}\\") + 1;
+            AddText(p, n);
+            p += n;
+        }
+    }
+    // The pattern was compiled
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Template::CompileLine(const char * pattern, const char * func, std::string & error)
+{
+    std::string line(pattern);
+    // Does the line end with a line break, either escaped or not?
+    const bool ends = (!line.empty() && line.back() == '\n') ||
+                        (line.size() >= 2 && line.compare(line.size() - 2, 2, "\\n") == 0);
+    // Add the line break if necessary
+    if (!ends)
+    {
+        line.push_back('\n');
+    }
+    // Compile the line
+    return Compile(line.c_str(), func, error);
+}
+
+// ------------------------------------------------------------------------------------------------
+void Template::Emit(const Instance & inst, Writer & out) const
+{
+    int32_t quant[3];
+    // Quantize the position up front like a whole list would be
+    QuantizePositions(&inst, 1, quant);
+    // Generate the output
+    Emit(inst, quant, out);
+}
+
+// ------------------------------------------------------------------------------------------------
+void Template::Emit(const Instance & inst, const int32_t * quant, Writer & out) const
+{
+    // The coordinates by axis
+    const double pos[3] = {inst.mX, inst.mY, inst.mZ};
+    // Run every step
+    for (const Step & step : m_Steps)
+    {
+        switch (step.mOp)
+        {
+            case Op::Text: out.Put(m_Text.data() + step.mBeg, step.mLen); break;
+            case Op::ID: out.Put(inst.mID); break;
+            case Op::Fixed: out.Put(pos[step.mAxis]); break;
+            case Op::Raw: out.Put(static_cast< int >(quant[step.mAxis])); break;
+            case Op::Short: out.PutShort(pos[step.mAxis]); break;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Template::Emit(const Instances & inst_list, Writer & out, const Progress & progress) const
+{
+    // Only quantize the positions if the pattern uses them
+    const bool raw = std::any_of(m_Steps.begin(), m_Steps.end(), [](const Step & step) {
+        return step.mOp == Op::Raw;
+    });
+    // The quantized positions of the block being generated
+    int32_t quant[QuantizeBlock * 3] = {};
+    // Process all instances in the list, one block at a time
+    for (size_t base = 0, n = inst_list.size(); base < n; base += QuantizeBlock)
+    {
+        const size_t count = std::min(QuantizeBlock, n - base);
+        // Quantize the whole block at once
+        if (raw)
+        {
+            QuantizePositions(inst_list.data() + base, count, quant);
+        }
+        // Generate the output of every instance in the block
+        for (size_t i = base, k = 0; k < count; ++i, ++k)
+        {
+            // Let the caller know how far we got and whether we should continue
+            if ((i % ProgressStep) == 0 && progress && !progress(i, n))
+            {
+                return false; // Cancelled!
+            }
+            Emit(inst_list[i], quant + k * 3, out);
+        }
+    }
+    // Report whether the output could be written
+    return !out.Failed();
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t Template::Lines() const
+{
+    return static_cast< size_t >(std::count(m_Text.begin(), m_Text.end(), '\n'));
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,103 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include "Instance.hpp"
+#include "Writer.hpp"
+#include "Progress.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Output text generated for every instance from a user supplied pattern. The pattern is compiled
+ * once into a flat list of steps, so emitting an instance never looks at the pattern again.
+ *
+ * Placeholders:
+ *  {func}                  The function name
+ *  {id}                    The model identifier
+ *  {x} {y} {z}             A coordinate with six decimals (like %f)
+ *  {x:raw} {y:raw} {z:raw} A coordinate quantized like the RAW output
+ *  {x:short} ...           A coordinate with the fewest digits that read back the same value
+ *
+ * Use {{ and }} for literal braces. The escapes \n, \t and \\ are also understood so patterns
+ * can be typed on a single line.
+*/
+class Template
+{
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * What a step produces.
+    */
+    enum class Op : uint8_t
+    {
+        Text, // A literal portion of the pattern
+        ID, // The model identifier
+        Fixed, // A coordinate with six decimals
+        Raw, // A quantized coordinate
+        Short // A coordinate in the shortest form
+    };
+
+    /* --------------------------------------------------------------------------------------------
+     * A single step of the compiled pattern.
+    */
+    struct Step
+    {
+        // ----------------------------------------------------------------------------------------
+        Op          mOp; // What the step produces
+        uint8_t     mAxis; // Which coordinate is used (0 for x, 1 for y, 2 for z)
+        uint32_t    mBeg; // Where the literal text starts
+        uint32_t    mLen; // Length of the literal text
+    };
+
+    // --------------------------------------------------------------------------------------------
+    std::vector< Step > m_Steps; // The compiled steps
+    std::string         m_Text; // Storage for the literal text of every step
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Compile the specified pattern. The function name is resolved right away.
+    */
+    bool Compile(const char * pattern, const char * func, std::string & error);
+
+    /* --------------------------------------------------------------------------------------------
+     * Compile a pattern that describes a single line, adding the line break if it is missing.
+    */
+    bool CompileLine(const char * pattern, const char * func, std::string & error);
+
+    /* --------------------------------------------------------------------------------------------
+     * Generate the output of every instance. The progress is measured in instances.
+    */
+    bool Emit(const Instances & inst_list, Writer & out,
+                const Progress & progress = Progress()) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Generate the output of a single instance.
+    */
+    void Emit(const Instance & inst, Writer & out) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of line breaks generated for every instance.
+    */
+    size_t Lines() const;
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * Generate the output of a single instance from its already quantized position.
+    */
+    void Emit(const Instance & inst, const int32_t * quant, Writer & out) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Append literal text, merging it with the previous step when possible.
+    */
+    void AddText(const char * s, size_t n);
+};
+
+} // Namespace:: VcMp
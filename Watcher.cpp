@@ -0,0 +1,349 @@
+// ------------------------------------------------------------------------------------------------
+#include "Watcher.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#ifdef __linux__
+    #include <poll.h>
+    #include <unistd.h>
+    #include <sys/inotify.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------
+#include <cerrno>
+#include <cstring>
+
+// ------------------------------------------------------------------------------------------------
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+
+// ------------------------------------------------------------------------------------------------
+const uint32_t WatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ * Remember the size and modification time of the files in a directory.
+*/
+template < typename M, typename I > void Scan(I itr, M & stamps)
+{
+    std::error_code ec;
+    // Look at every entry and ignore those that go away in the meantime
+    for (I end; !ec && itr != end; itr.increment(ec))
+    {
+        if (!itr->is_regular_file(ec))
+        {
+            continue;
+        }
+        const uint64_t size = itr->file_size(ec);
+        const int64_t time = itr->last_write_time(ec).time_since_epoch().count();
+        // Remember the file, if it's still there
+        if (!ec)
+        {
+            stamps[itr->path().string()] = {size, time};
+        }
+        ec.clear();
+    }
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+Watcher::Watcher()
+    : m_Handle(-1), m_Dirs(), m_Stamps()
+{
+#ifdef __linux__
+    m_Handle = inotify_init1(IN_CLOEXEC);
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+Watcher::~Watcher()
+{
+#ifdef __linux__
+    if (m_Handle >= 0)
+    {
+        close(m_Handle);
+    }
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Watcher::Add(const std::string & path, std::string & error)
+{
+    std::error_code ec;
+    // Directories are watched with everything in them
+    if (fs::is_directory(path, ec))
+    {
+        return Watch(path, true, error);
+    }
+    // Files are watched through their directory, since editors often replace them
+    const fs::path parent = fs::path(path).parent_path();
+    // Files without a directory are in the current one
+    return Watch(parent.empty() ? std::string(".") : parent.string(), false, error);
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Watcher::Wait(std::vector< Change > & changes, std::string & error)
+{
+    changes.clear();
+#ifdef __linux__
+    // Was inotify available?
+    if (m_Handle >= 0)
+    {
+        // Wait for the first change
+        while (changes.empty())
+        {
+            if (!Read(-1, changes, error))
+            {
+                return false;
+            }
+        }
+        // Keep collecting until nothing arrives for a while
+        for (size_t count = 0; count != changes.size(); )
+        {
+            count = changes.size();
+            // Take in whatever else arrives in the meantime
+            if (!Read(Settle, changes, error))
+            {
+                return false;
+            }
+        }
+    }
+    else
+#endif
+    {
+        // Check every now and then until something changes
+        while (changes.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(Interval));
+            Poll(changes);
+        }
+        // Keep collecting until nothing changes for a while
+        for (size_t count = 0; count != changes.size(); )
+        {
+            count = changes.size();
+            std::this_thread::sleep_for(std::chrono::milliseconds(Settle));
+            Poll(changes);
+        }
+    }
+    // Report each path only once
+    std::sort(changes.begin(), changes.end(), [](const Change & a, const Change & b) {
+        return a.mPath < b.mPath || (a.mPath == b.mPath && a.mDirectory > b.mDirectory);
+    });
+    changes.erase(std::unique(changes.begin(), changes.end(),
+                        [](const Change & a, const Change & b) { return a.mPath == b.mPath; }),
+                    changes.end());
+    // Something changed
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Watcher::Watch(const std::string & dir, bool recursive, std::string & error)
+{
+    std::error_code ec;
+#ifdef __linux__
+    // Was inotify available?
+    if (m_Handle >= 0)
+    {
+        const int wd = inotify_add_watch(m_Handle, dir.c_str(), WatchMask | IN_ONLYDIR);
+        // Could the directory be watched?
+        if (wd < 0)
+        {
+            error = "Unable to watch directory: " + dir + " (" + std::strerror(errno) + ")";
+            // We're done here
+            return false;
+        }
+        // The same directory may be reached through several inputs
+        Directory & entry = m_Dirs[wd];
+        entry.mRecursive = entry.mRecursive || recursive;
+        entry.mPath = dir;
+        // Is that all?
+        if (!recursive)
+        {
+            return true;
+        }
+        // Sub-directories need watches of their own
+        for (fs::recursive_directory_iterator itr(dir, ec), end; !ec && itr != end;
+                                                                        itr.increment(ec))
+        {
+            if (!itr->is_directory(ec))
+            {
+                continue;
+            }
+            const std::string sub = itr->path().string();
+            const int swd = inotify_add_watch(m_Handle, sub.c_str(), WatchMask | IN_ONLYDIR);
+            // Directories that go away in the meantime are of no interest
+            if (swd >= 0)
+            {
+                m_Dirs[swd] = Directory{sub, true};
+            }
+        }
+        // Directories that cannot be searched can still be watched
+        return true;
+    }
+#endif
+    // Remember the directory so it can be checked every now and then
+    m_Dirs.emplace(static_cast< int >(m_Dirs.size()), Directory{dir, recursive});
+    // Remember what the files look like right now
+    if (recursive)
+    {
+        Scan(fs::recursive_directory_iterator(dir, ec), m_Stamps);
+    }
+    else
+    {
+        Scan(fs::directory_iterator(dir, ec), m_Stamps);
+    }
+    // Could the directory be searched?
+    if (ec)
+    {
+        error = "Unable to watch directory: " + dir + " (" + ec.message() + ")";
+        // We're done here
+        return false;
+    }
+    // The directory is being watched
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Watcher::Read(int timeout, std::vector< Change > & changes, std::string & error)
+{
+#ifdef __linux__
+    pollfd pfd = {m_Handle, POLLIN, 0};
+    // Wait for notifications to arrive
+    const int ready = poll(&pfd, 1, timeout);
+    if (ready <= 0)
+    {
+        // Interruptions and timeouts are not failures
+        if (ready < 0 && errno != EINTR)
+        {
+            error = std::string("Unable to wait for changes (") + std::strerror(errno) + ")";
+            // We're done here
+            return false;
+        }
+        return true;
+    }
+    // Notifications are aligned to their structure
+    alignas(inotify_event) char buffer[64 * 1024];
+    const ssize_t size = read(m_Handle, buffer, sizeof(buffer));
+    if (size < 0)
+    {
+        if (errno != EINTR && errno != EAGAIN)
+        {
+            error = std::string("Unable to read changes (") + std::strerror(errno) + ")";
+            // We're done here
+            return false;
+        }
+        return true;
+    }
+    // Process every notification
+    for (const char * p = buffer; p < buffer + size; )
+    {
+        const inotify_event * ev = reinterpret_cast< const inotify_event * >(p);
+        p += sizeof(inotify_event) + ev->len;
+        // Were notifications lost? Then anything could have changed
+        if (ev->mask & IN_Q_OVERFLOW)
+        {
+            for (const auto & d : m_Dirs)
+            {
+                changes.push_back(Change{d.second.mPath, true});
+            }
+            continue;
+        }
+        auto itr = m_Dirs.find(ev->wd);
+        // Is this a directory that we still know about?
+        if (itr == m_Dirs.end())
+        {
+            continue;
+        }
+        // The directory itself went away
+        else if (ev->mask & IN_IGNORED)
+        {
+            m_Dirs.erase(itr);
+            continue;
+        }
+        // Only look at what happens to the entries in the directory
+        else if (ev->len == 0)
+        {
+            continue;
+        }
+        const bool recursive = itr->second.mRecursive;
+        const std::string path = (fs::path(itr->second.mPath) / ev->name).string();
+        // Is this about a whole directory?
+        if (ev->mask & IN_ISDIR)
+        {
+            std::string ignored;
+            // Directories that appear in watched trees must be watched as well
+            if (recursive && (ev->mask & (IN_CREATE | IN_MOVED_TO)))
+            {
+                Watch(path, true, ignored);
+            }
+            changes.push_back(Change{path, true});
+        }
+        // Files are only reported once they are complete
+        else if (!(ev->mask & IN_CREATE))
+        {
+            changes.push_back(Change{path, false});
+        }
+    }
+#else
+    static_cast< void >(timeout), static_cast< void >(changes), static_cast< void >(error);
+#endif
+    // Notifications were processed
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+void Watcher::Poll(std::vector< Change > & changes)
+{
+    std::unordered_map< std::string, Stamp > stamps;
+    std::error_code ec;
+    // Look at what the files look like right now
+    for (const auto & d : m_Dirs)
+    {
+        if (d.second.mRecursive)
+        {
+            Scan(fs::recursive_directory_iterator(d.second.mPath, ec), stamps);
+        }
+        else
+        {
+            Scan(fs::directory_iterator(d.second.mPath, ec), stamps);
+        }
+        ec.clear();
+    }
+    // Report files that appeared or changed
+    for (const auto & s : stamps)
+    {
+        auto itr = m_Stamps.find(s.first);
+        // Is this a new file or a different one?
+        if (itr == m_Stamps.end() || itr->second.mSize != s.second.mSize ||
+            itr->second.mTime != s.second.mTime)
+        {
+            changes.push_back(Change{s.first, false});
+        }
+    }
+    // Report files that went away
+    for (const auto & s : m_Stamps)
+    {
+        if (stamps.find(s.first) == stamps.end())
+        {
+            changes.push_back(Change{s.first, false});
+        }
+    }
+    // This is what they look like from now on
+    m_Stamps.swap(stamps);
+}
+
+} // Namespace:: VcMp
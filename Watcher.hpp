@@ -0,0 +1,117 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdint>
+
+// ------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Waits for files to change. Directories are watched as a whole so that editors which save by
+ * replacing the file are still noticed, and every file that changes in them is reported. Uses
+ * inotify on Linux and compares the modification times every so often everywhere else.
+*/
+class Watcher
+{
+public:
+
+    // --------------------------------------------------------------------------------------------
+    static constexpr int Settle = 100; // Milliseconds without changes before they are reported
+    static constexpr int Interval = 250; // Milliseconds between checks when polling
+
+    /* --------------------------------------------------------------------------------------------
+     * Something that changed in a watched directory.
+    */
+    struct Change
+    {
+        // ----------------------------------------------------------------------------------------
+        std::string mPath; // Path of what changed
+        bool        mDirectory; // Whether a whole directory appeared, went away or was missed
+    };
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * A directory being watched.
+    */
+    struct Directory
+    {
+        // ----------------------------------------------------------------------------------------
+        std::string mPath; // Path of the directory
+        bool        mRecursive; // Whether sub-directories are also watched
+    };
+
+    /* --------------------------------------------------------------------------------------------
+     * What was last seen of a file. (only when polling)
+    */
+    struct Stamp
+    {
+        // ----------------------------------------------------------------------------------------
+        uint64_t    mSize; // Size of the file
+        int64_t     mTime; // Modification time of the file
+    };
+
+    // --------------------------------------------------------------------------------------------
+    int                                         m_Handle; // Notification handle, if any
+    std::unordered_map< int, Directory >        m_Dirs; // Watched directories by identifier
+    std::unordered_map< std::string, Stamp >    m_Stamps; // Files last seen (only when polling)
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Default constructor.
+    */
+    Watcher();
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy constructor. (disabled)
+    */
+    Watcher(const Watcher &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Destructor.
+    */
+    ~Watcher();
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy assignment operator. (disabled)
+    */
+    Watcher & operator = (const Watcher &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Watch the specified file or directory. Files are watched through the directory they are in
+     * and directories are watched together with every sub-directory.
+    */
+    bool Add(const std::string & path, std::string & error);
+
+    /* --------------------------------------------------------------------------------------------
+     * Block until something changes and retrieve what changed. Changes are collected until they
+     * settle down so that a file which is saved in several steps is only reported once.
+    */
+    bool Wait(std::vector< Change > & changes, std::string & error);
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * Start watching a single directory and, if requested, every sub-directory.
+    */
+    bool Watch(const std::string & dir, bool recursive, std::string & error);
+
+    /* --------------------------------------------------------------------------------------------
+     * Take in the pending notifications. Waits up to the specified number of milliseconds for
+     * them to arrive, or indefinitely when negative.
+    */
+    bool Read(int timeout, std::vector< Change > & changes, std::string & error);
+
+    /* --------------------------------------------------------------------------------------------
+     * Compare the watched files with what was last seen. (only when polling)
+    */
+    void Poll(std::vector< Change > & changes);
+};
+
+} // Namespace:: VcMp
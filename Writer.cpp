@@ -0,0 +1,292 @@
+// ------------------------------------------------------------------------------------------------
+#include "Writer.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdint>
+
+// ------------------------------------------------------------------------------------------------
+#include <charconv>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * The digits of every number from 0 to 99, so integers can be written two digits at a time.
+*/
+const char DigitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* ------------------------------------------------------------------------------------------------
+ * Retrieve the number of decimal digits in the specified value.
+*/
+inline unsigned CountDigits(uint32_t v)
+{
+    unsigned n = 1;
+    // Coordinates are mostly 4 or 5 digits, so skip ahead 4 digits at a time
+    for (; v >= 10000; v /= 10000)
+    {
+        n += 4;
+    }
+    // Count the rest
+    return n + (v >= 10) + (v >= 100) + (v >= 1000);
+}
+
+} // Namespace:: (anonymous)
+
+// ------------------------------------------------------------------------------------------------
+Writer::Writer(std::FILE * file)
+    : m_Chunks(), m_Data(), m_Cur(nullptr), m_End(nullptr)
+    , m_File(file), m_Capacity(MinChunkSize), m_Written(0), m_Failed(false)
+{
+    /* ... */
+}
+
+// ------------------------------------------------------------------------------------------------
+Writer::Writer(Writer && o) noexcept
+    : m_Chunks(std::move(o.m_Chunks)), m_Data(std::move(o.m_Data)), m_Cur(o.m_Cur), m_End(o.m_End)
+    , m_File(o.m_File), m_Capacity(o.m_Capacity), m_Written(o.m_Written), m_Failed(o.m_Failed)
+{
+    // The other writer must not keep pointing into the chunk it gave away
+    o.m_Chunks.clear();
+    o.m_Cur = o.m_End = nullptr;
+    o.m_File = nullptr;
+    o.m_Capacity = MinChunkSize, o.m_Written = 0, o.m_Failed = false;
+}
+
+// ------------------------------------------------------------------------------------------------
+Writer & Writer::operator = (Writer && o) noexcept
+{
+    if (this != &o)
+    {
+        m_Chunks = std::move(o.m_Chunks), m_Data = std::move(o.m_Data);
+        m_Cur = o.m_Cur, m_End = o.m_End;
+        m_File = o.m_File, m_Capacity = o.m_Capacity;
+        m_Written = o.m_Written, m_Failed = o.m_Failed;
+        // The other writer must not keep pointing into the chunk it gave away
+        o.m_Chunks.clear();
+        o.m_Cur = o.m_End = nullptr;
+        o.m_File = nullptr;
+        o.m_Capacity = MinChunkSize, o.m_Written = 0, o.m_Failed = false;
+    }
+    return *this;
+}
+
+// ------------------------------------------------------------------------------------------------
+void Writer::Put(int v)
+{
+    // The longest integer is 11 characters
+    if (m_End - m_Cur < 11)
+    {
+        Spill();
+    }
+    uint32_t u = static_cast< uint32_t >(v);
+    // Write the sign and continue with the magnitude
+    if (v < 0)
+    {
+        *m_Cur++ = '-';
+        u = 0u - u;
+    }
+    // The digits are written backwards from the end
+    m_Cur += CountDigits(u);
+    char * p = m_Cur;
+    // Write two digits at a time
+    while (u >= 100)
+    {
+        const uint32_t r = (u % 100) * 2;
+        u /= 100;
+        p -= 2, p[0] = DigitPairs[r], p[1] = DigitPairs[r + 1];
+    }
+    // Write the leading digits
+    if (u >= 10)
+    {
+        p[-2] = DigitPairs[u * 2], p[-1] = DigitPairs[u * 2 + 1];
+    }
+    else
+    {
+        p[-1] = static_cast< char >('0' + u);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+void Writer::PutLong(int64_t v)
+{
+    // Most values fit the faster path
+    if (v >= INT32_MIN && v <= INT32_MAX)
+    {
+        Put(static_cast< int >(v));
+        // We're done here
+        return;
+    }
+    // The longest 64-bit integer is 20 characters
+    char buffer[24];
+    const std::to_chars_result r = std::to_chars(buffer, buffer + sizeof(buffer), v);
+    // Append the formatted value
+    Put(buffer, static_cast< size_t >(r.ptr - buffer));
+}
+
+// ------------------------------------------------------------------------------------------------
+void Writer::Put(double v)
+{
+    // Attempt to format the value in place (fails without a chunk)
+    std::to_chars_result r = std::to_chars(m_Cur, m_End, v, std::chars_format::fixed, 6);
+    // Did it fit?
+    if (r.ec == std::errc())
+    {
+        m_Cur = r.ptr;
+        // We're done here
+        return;
+    }
+    // The longest value is 309 digits, the sign, the decimal point and the decimals
+    char buffer[320];
+    r = std::to_chars(buffer, buffer + sizeof(buffer), v, std::chars_format::fixed, 6);
+    // Append the formatted value
+    PutSlow(buffer, static_cast< size_t >(r.ptr - buffer));
+}
+
+// ------------------------------------------------------------------------------------------------
+void Writer::PutShort(double v)
+{
+    // The longest shortest form is 24 characters
+    char buffer[32];
+    const std::to_chars_result r = std::to_chars(buffer, buffer + sizeof(buffer), v);
+    // Append the formatted value
+    Put(buffer, static_cast< size_t >(r.ptr - buffer));
+}
+
+// ------------------------------------------------------------------------------------------------
+size_t Writer::Size() const
+{
+    size_t size = m_Written + static_cast< size_t >(m_Cur - m_Data.get());
+    // Include the stored chunks
+    for (const auto & chunk : m_Chunks)
+    {
+        size += chunk.mSize;
+    }
+    // Return the total size
+    return size;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Writer::Flush()
+{
+    // Is there a file to send the pending output to?
+    if (m_File != nullptr)
+    {
+        Spill();
+        // Make sure the output reaches the file
+        m_Failed |= (std::fflush(m_File) != 0);
+    }
+    // Report whether we wrote everything
+    return !m_Failed;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool Writer::WriteTo(std::FILE * file) const
+{
+    // Write the stored chunks first
+    for (const auto & chunk : m_Chunks)
+    {
+        if (std::fwrite(chunk.mData.get(), 1, chunk.mSize, file) != chunk.mSize)
+        {
+            return false;
+        }
+    }
+    // Write the chunk being filled, unless there is none
+    const size_t size = static_cast< size_t >(m_Cur - m_Data.get());
+    // Report whether everything was written
+    return size == 0 || std::fwrite(m_Data.get(), 1, size, file) == size;
+}
+
+// ------------------------------------------------------------------------------------------------
+void Writer::CopyTo(char * dest) const
+{
+    // Copy the stored chunks
+    for (const auto & chunk : m_Chunks)
+    {
+        std::memcpy(dest, chunk.mData.get(), chunk.mSize);
+        dest += chunk.mSize;
+    }
+    // Include the chunk being filled, unless there is none
+    if (m_Cur != m_Data.get())
+    {
+        std::memcpy(dest, m_Data.get(), static_cast< size_t >(m_Cur - m_Data.get()));
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+std::string Writer::Str() const
+{
+    std::string str;
+    // Allocate the whole string at once
+    str.reserve(Size());
+    // Join the stored chunks
+    for (const auto & chunk : m_Chunks)
+    {
+        str.append(chunk.mData.get(), chunk.mSize);
+    }
+    // Include the chunk being filled
+    str.append(m_Data.get(), static_cast< size_t >(m_Cur - m_Data.get()));
+    // Return the joined output
+    return str;
+}
+
+// ------------------------------------------------------------------------------------------------
+void Writer::Clear()
+{
+    m_Chunks.clear();
+    m_Cur = m_Data.get();
+}
+
+// ------------------------------------------------------------------------------------------------
+void Writer::Spill()
+{
+    const size_t size = static_cast< size_t >(m_Cur - m_Data.get());
+    // Is the output sent to a file?
+    if (m_File != nullptr)
+    {
+        m_Failed |= (std::fwrite(m_Data.get(), 1, size, m_File) != size);
+        // Remember how much we wrote
+        m_Written += size;
+    }
+    // Is there anything worth storing?
+    else if (size > 0)
+    {
+        m_Chunks.push_back({std::move(m_Data), size});
+    }
+    // Do we need a new chunk?
+    if (!m_Data)
+    {
+        m_Data.reset(new char[m_Capacity]);
+        m_End = m_Data.get() + m_Capacity;
+        // The next chunk can be larger
+        m_Capacity = std::min(m_Capacity * 2, MaxChunkSize);
+    }
+    // Reuse or start the chunk from the beginning
+    m_Cur = m_Data.get();
+}
+
+// ------------------------------------------------------------------------------------------------
+void Writer::PutSlow(const char * s, size_t n)
+{
+    while (n > 0)
+    {
+        // Is the chunk being filled full?
+        if (m_Cur == m_End)
+        {
+            Spill();
+        }
+        // Copy as much as we can
+        const size_t len = std::min(n, static_cast< size_t >(m_End - m_Cur));
+        std::memcpy(m_Cur, s, len);
+        // Move past the copied portion
+        m_Cur += len, s += len, n -= len;
+    }
+}
+
+} // Namespace:: VcMp
@@ -0,0 +1,196 @@
+#pragma once
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <memory>
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+/* ------------------------------------------------------------------------------------------------
+ * Accumulates generated output into large chunks. Numbers are formatted straight into the chunks
+ * without going through the locale. When a file is attached, every filled chunk is written to it
+ * and reused, otherwise the chunks are kept until the output is taken in one piece. Chunks start
+ * small and grow so that many small outputs can be kept around cheaply.
+*/
+class Writer
+{
+public:
+
+    // --------------------------------------------------------------------------------------------
+    static constexpr size_t MinChunkSize = 64 * 1024; // Size of the first chunk
+    static constexpr size_t MaxChunkSize = 1024 * 1024; // Size that chunks grow up to
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * A block of generated output.
+    */
+    struct Chunk
+    {
+        // ----------------------------------------------------------------------------------------
+        std::unique_ptr< char[] >   mData; // Chunk contents
+        size_t                      mSize; // Bytes used in the chunk
+    };
+
+    // --------------------------------------------------------------------------------------------
+    std::vector< Chunk >    m_Chunks; // Filled chunks (only when not writing to a file)
+    std::unique_ptr< char[] > m_Data; // Chunk being filled
+    char *                  m_Cur; // Where the next byte goes
+    char *                  m_End; // End of the chunk being filled
+    std::FILE *             m_File; // File receiving the output, if any
+    size_t                  m_Capacity; // Size of the next allocated chunk
+    size_t                  m_Written; // Bytes that already left the chunk being filled
+    bool                    m_Failed; // Whether writing to the file failed
+
+public:
+
+    /* --------------------------------------------------------------------------------------------
+     * Base constructor. Output is sent to the specified file or kept in memory when null.
+    */
+    explicit Writer(std::FILE * file = nullptr);
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy constructor. (disabled)
+    */
+    Writer(const Writer &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Move constructor. The other writer is left empty, without a file, as if newly constructed.
+    */
+    Writer(Writer && o) noexcept;
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy assignment operator. (disabled)
+    */
+    Writer & operator = (const Writer &) = delete;
+
+    /* --------------------------------------------------------------------------------------------
+     * Move assignment operator. The other writer is left empty, without a file.
+    */
+    Writer & operator = (Writer && o) noexcept;
+
+    /* --------------------------------------------------------------------------------------------
+     * Append a single character.
+    */
+    void Put(char c)
+    {
+        if (m_Cur == m_End)
+        {
+            Spill();
+        }
+        *m_Cur++ = c;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Append a null terminated string.
+    */
+    void Put(const char * s)
+    {
+        Put(s, std::strlen(s));
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Append a string with a known length.
+    */
+    void Put(const char * s, size_t n)
+    {
+        // The common case where everything fits
+        if (static_cast< size_t >(m_End - m_Cur) >= n)
+        {
+            std::memcpy(m_Cur, s, n);
+            m_Cur += n;
+        }
+        else
+        {
+            PutSlow(s, n);
+        }
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Append a string.
+    */
+    void Put(const std::string & s)
+    {
+        Put(s.data(), s.size());
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Append an integer in decimal form.
+    */
+    void Put(int v);
+
+    /* --------------------------------------------------------------------------------------------
+     * Append a 64-bit integer in decimal form.
+    */
+    void PutLong(int64_t v);
+
+    /* --------------------------------------------------------------------------------------------
+     * Append a floating point value with six decimals, exactly like the %f conversion.
+    */
+    void Put(double v);
+
+    /* --------------------------------------------------------------------------------------------
+     * Append a floating point value with the fewest digits that read back as the same value.
+    */
+    void PutShort(double v);
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the number of bytes generated so far.
+    */
+    size_t Size() const;
+
+    /* --------------------------------------------------------------------------------------------
+     * See whether writing to the file failed at any point.
+    */
+    bool Failed() const
+    {
+        return m_Failed;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Send whatever is still pending to the file. Returns false if writing failed at any point.
+    */
+    bool Flush();
+
+    /* --------------------------------------------------------------------------------------------
+     * Write the output kept in memory to the specified file.
+    */
+    bool WriteTo(std::FILE * file) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Copy the output kept in memory to a buffer that holds at least Size() bytes.
+    */
+    void CopyTo(char * dest) const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Join the output kept in memory into a single string.
+    */
+    std::string Str() const;
+
+    /* --------------------------------------------------------------------------------------------
+     * Discard the output kept in memory.
+    */
+    void Clear();
+
+private:
+
+    /* --------------------------------------------------------------------------------------------
+     * Make room for more output by either writing or storing the chunk being filled.
+    */
+    void Spill();
+
+    /* --------------------------------------------------------------------------------------------
+     * Append a string that does not fit in the chunk being filled.
+    */
+    void PutSlow(const char * s, size_t n);
+};
+
+} // Namespace:: VcMp
@@ -0,0 +1,553 @@
+// ------------------------------------------------------------------------------------------------
+#include "Parser.hpp"
+#include "Scanner.hpp"
+#include "Builder.hpp"
+#include "Template.hpp"
+#include "Columns.hpp"
+#include "Quantize.hpp"
+#include "SpatialIndex.hpp"
+
+// ------------------------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+// ------------------------------------------------------------------------------------------------
+#include <new>
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+std::atomic< size_t > g_Allocations(0); // Number of allocations so far
+std::atomic< size_t > g_AllocatedBytes(0); // Number of allocated bytes so far
+
+// ------------------------------------------------------------------------------------------------
+const double MinSeconds = 0.05; // Shortest time a measurement runs, so timer noise stays small
+
+} // Namespace:: (anonymous)
+
+/* ------------------------------------------------------------------------------------------------
+ * Count every allocation made by the measured code.
+*/
+void * operator new (size_t size)
+{
+    ++g_Allocations;
+    g_AllocatedBytes += size;
+    // Perform the allocation
+    if (void * p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// ------------------------------------------------------------------------------------------------
+void * operator new[] (size_t size)
+{
+    return operator new (size);
+}
+
+// ------------------------------------------------------------------------------------------------
+void operator delete (void * p) noexcept
+{
+    std::free(p);
+}
+
+// ------------------------------------------------------------------------------------------------
+void operator delete[] (void * p) noexcept
+{
+    std::free(p);
+}
+
+// ------------------------------------------------------------------------------------------------
+void operator delete (void * p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// ------------------------------------------------------------------------------------------------
+void operator delete[] (void * p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// ------------------------------------------------------------------------------------------------
+namespace VcMp {
+
+// ------------------------------------------------------------------------------------------------
+namespace {
+
+/* ------------------------------------------------------------------------------------------------
+ * Options received from the command line.
+*/
+struct Options
+{
+    // --------------------------------------------------------------------------------------------
+    std::vector< size_t >   mSizes = {1000, 10000, 100000, 1000000}; // Instances per input
+    unsigned                mRepeat = 3; // Runs of each stage (the fastest one is kept)
+    unsigned                mSeed = 1; // Seed of the synthetic data
+    std::string             mJson; // Where to save the results
+    std::string             mBaseline; // Results to compare against
+    double                  mTolerance = 10.0; // Slowdown tolerated before a regression (%)
+    double                  mFloor = 1.0; // Stages faster than this are not compared (ms)
+    std::string             mDump; // Where to save the largest synthetic input
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * The measurement of a single stage.
+*/
+struct Result
+{
+    // --------------------------------------------------------------------------------------------
+    std::string mStage; // Stage that was measured
+    std::string mMode; // Output mode (empty when not formatting)
+    size_t      mInstances = 0; // Number of processed instances
+    size_t      mBytes = 0; // Number of processed bytes (input or output)
+    double      mSeconds = 0.0; // Time taken by the fastest run
+    size_t      mAllocations = 0; // Allocations made by one run
+    size_t      mAllocatedBytes = 0; // Bytes allocated by one run
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the throughput in megabytes per second.
+    */
+    double MBps() const
+    {
+        return mSeconds > 0.0 ? (mBytes / (1024.0 * 1024.0)) / mSeconds : 0.0;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the throughput in instances per second.
+    */
+    double IPS() const
+    {
+        return mSeconds > 0.0 ? mInstances / mSeconds : 0.0;
+    }
+
+    /* --------------------------------------------------------------------------------------------
+     * Retrieve the key that identifies this measurement across runs.
+    */
+    std::string Key() const
+    {
+        return mStage + "/" + mMode + "/" + std::to_string(mInstances);
+    }
+};
+
+/* ------------------------------------------------------------------------------------------------
+ * Generate Vice City style IPL data with the specified number of instances. The data contains
+ * comments, blank lines, other sections and inconsistent spacing like hand edited files do.
+*/
+std::string Generate(size_t count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution< double > coord(-2400.0, 2400.0), height(-50.0, 300.0);
+    std::uniform_real_distribution< double > rot(-1.0, 1.0);
+    std::uniform_int_distribution< int > model(100, 6500), chance(0, 99);
+    // Separators as found in the wild
+    static const char * const seps[] = {", ", ",", " , ", ",\t", ",  "};
+    // The generated data
+    std::string ipl;
+    ipl.reserve(count * 110 + 256);
+    ipl.append("# IPL generated by the benchmark\r\n");
+    ipl.append("\ncull\n  1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11\nend\n\n");
+    ipl.append("inst\n");
+    // Scratch buffer for each line
+    char line[256];
+    for (size_t i = 0; i < count; ++i)
+    {
+        const int c = chance(rng);
+        // Sprinkle comments and blank lines
+        if (c < 3)
+        {
+            ipl.append("# a comment about the next object\n");
+        }
+        else if (c < 5)
+        {
+            ipl.append(c == 3 ? "\n" : "  \t \n");
+        }
+        const char * sep = seps[chance(rng) % 5];
+        const int id = model(rng);
+        // Format the instance
+        const int n = std::snprintf(line, sizeof(line),
+            "%s%d%sobject%d%s0%s%.6f%s%.5f%s%.4f%s1%s1%s1%s%.6f%s%.6f%s%.6f%s%.6f%s\n",
+            (c % 10) == 0 ? "  " : "", id, sep, id, sep, sep,
+            coord(rng), sep, coord(rng), sep, height(rng), sep, sep, sep, sep,
+            rot(rng), sep, rot(rng), sep, rot(rng), sep, rot(rng), (c % 7) == 0 ? "\r" : "");
+        ipl.append(line, static_cast< size_t >(n));
+    }
+    ipl.append("end\npath\nend\n");
+    // Return the generated data
+    return ipl;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Run the specified function a few times and keep the fastest run. Stages that finish quickly are
+ * run again until the measurement takes at least MinSeconds, and each run counts for its share.
+*/
+template < typename F > Result Measure(const char * stage, const char * mode, unsigned repeat,
+                                        F && fn)
+{
+    Result r;
+    r.mStage = stage, r.mMode = mode;
+    r.mSeconds = 1e300;
+    for (unsigned i = 0; i < std::max(repeat, 1u); ++i)
+    {
+        const size_t allocs = g_Allocations, bytes = g_AllocatedBytes;
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::duration< double > elapsed(0.0);
+        size_t runs = 0;
+        // Run the stage until enough time was measured
+        do
+        {
+            fn(r);
+            ++runs;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < MinSeconds);
+        // Keep the fastest run
+        r.mSeconds = std::min(r.mSeconds, elapsed.count() / runs);
+        r.mAllocations = (g_Allocations - allocs) / runs;
+        r.mAllocatedBytes = (g_AllocatedBytes - bytes) / runs;
+    }
+    // Return the measurement
+    return r;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Load the results of a previous run. Each result is stored on its own line.
+*/
+bool LoadResults(const char * path, std::vector< Result > & results)
+{
+    std::FILE * file = std::fopen(path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    char line[1024];
+    // Extract the value of a field from a line
+    auto field = [&line](const char * name) -> const char * {
+        const char * p = std::strstr(line, name);
+        return p ? p + std::strlen(name) : nullptr;
+    };
+    while (std::fgets(line, sizeof(line), file))
+    {
+        const char * stage = field("\"stage\": \""), * mode = field("\"mode\": \"");
+        const char * instances = field("\"instances\": "), * seconds = field("\"seconds\": ");
+        // Is this a result line?
+        if (!stage || !mode || !instances || !seconds)
+        {
+            continue;
+        }
+        Result r;
+        r.mStage.assign(stage, std::strchr(stage, '"'));
+        r.mMode.assign(mode, std::strchr(mode, '"'));
+        r.mInstances = std::strtoull(instances, nullptr, 10);
+        r.mSeconds = std::strtod(seconds, nullptr);
+        results.push_back(r);
+    }
+    std::fclose(file);
+    // Results were loaded
+    return true;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Save the results in a machine readable form.
+*/
+bool SaveResults(const char * path, const std::vector< Result > & results)
+{
+    std::FILE * file = std::fopen(path, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    std::fprintf(file, "{\n  \"version\": 1,\n  \"kernel\": \"%s\",\n  \"results\": [\n",
+                    Scanner::Kernel());
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result & r = results[i];
+        std::fprintf(file, "    {\"stage\": \"%s\", \"mode\": \"%s\", \"instances\": %zu, "
+                            "\"bytes\": %zu, \"seconds\": %.9f, \"mb_per_s\": %.3f, "
+                            "\"instances_per_s\": %.1f, \"allocations\": %zu, "
+                            "\"allocated_bytes\": %zu}%s\n",
+                        r.mStage.c_str(), r.mMode.c_str(), r.mInstances, r.mBytes, r.mSeconds,
+                        r.MBps(), r.IPS(), r.mAllocations, r.mAllocatedBytes,
+                        i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    // Report whether everything was written
+    return std::fclose(file) == 0;
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Display the command line usage.
+*/
+void Usage(const char * exe)
+{
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --sizes <n[,n...]>     Instances per synthetic input\n"
+        "                         (default: 1000,10000,100000,1000000)\n"
+        "  --repeat <count>       Runs of each stage, the fastest is kept (default: 3)\n"
+        "  --seed <value>         Seed of the synthetic data (default: 1)\n"
+        "  --json <path>          Save the results in a machine readable form\n"
+        "  --baseline <path>      Compare against previously saved results\n"
+        "  --tolerance <percent>  Slowdown tolerated before a regression (default: 10)\n"
+        "  --floor <ms>           Stages faster than this are not compared (default: 1)\n"
+        "  --dump <path>          Save the largest synthetic input\n", exe);
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * Parse the command line into the specified options.
+*/
+bool ParseOptions(int argc, char ** argv, Options & opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char * arg = argv[i];
+        // Every option expects a value
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        const char * val = argv[++i];
+        // Identify the option
+        if (std::strcmp(arg, "--sizes") == 0)
+        {
+            opts.mSizes.clear();
+            // Parse the comma separated list
+            for (char * end = nullptr; *val != '\0'; val = (*end == ',') ? end + 1 : end)
+            {
+                opts.mSizes.push_back(std::strtoull(val, &end, 10));
+                // Was there a value?
+                if (end == val)
+                {
+                    return false;
+                }
+            }
+        }
+        else if (std::strcmp(arg, "--repeat") == 0)
+        {
+            opts.mRepeat = static_cast< unsigned >(std::strtoul(val, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--seed") == 0)
+        {
+            opts.mSeed = static_cast< unsigned >(std::strtoul(val, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--json") == 0)
+        {
+            opts.mJson = val;
+        }
+        else if (std::strcmp(arg, "--baseline") == 0)
+        {
+            opts.mBaseline = val;
+        }
+        else if (std::strcmp(arg, "--tolerance") == 0)
+        {
+            opts.mTolerance = std::strtod(val, nullptr);
+        }
+        else if (std::strcmp(arg, "--floor") == 0)
+        {
+            opts.mFloor = std::strtod(val, nullptr);
+        }
+        else if (std::strcmp(arg, "--dump") == 0)
+        {
+            opts.mDump = val;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    // Options are valid
+    return !opts.mSizes.empty();
+}
+
+} // Namespace:: (anonymous)
+
+} // Namespace:: VcMp
+
+// ------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv)
+{
+    using namespace VcMp;
+    Options opts;
+    // Attempt to parse the command line
+    if (!ParseOptions(argc, argv, opts))
+    {
+        Usage(argv[0]);
+        // We're done here
+        return EXIT_FAILURE;
+    }
+    // Output modes that are measured
+    static const Format modes[] = {Format::XML, Format::NUT, Format::RAW, Format::BIN,
+                                    Format::TNUT, Format::TRAW, Format::DELTA, Format::GNUT,
+                                    Format::GRAW};
+    static const char * const names[] = {"xml", "nut", "raw", "bin", "tnut", "traw", "delta",
+                                            "gnut", "graw"};
+    // Problems are not expected in the synthetic data
+    const Reporter report = [](Category /*cat*/, const char * msg, int line) {
+        std::fprintf(stderr, "Unexpected problem: %s: %d\n", msg, line);
+    };
+    // Collected measurements
+    std::vector< Result > results;
+    // Stages that disagreed on what they produced
+    size_t mismatches = 0;
+    std::printf("Scanner kernel: %s\n", Scanner::Kernel());
+    std::printf("Quantize kernel: %s\n", QuantizeKernel());
+    std::printf("%-8s %-5s %10s %12s %10s %14s %12s\n",
+                "stage", "mode", "instances", "seconds", "MB/s", "instances/s", "allocations");
+    // Display and store a measurement
+    auto record = [&results](const Result & r) {
+        std::printf("%-8s %-5s %10zu %12.6f %10.1f %14.0f %12zu\n", r.mStage.c_str(),
+                    r.mMode.c_str(), r.mInstances, r.mSeconds, r.MBps(), r.IPS(), r.mAllocations);
+        results.push_back(r);
+    };
+    // Measure every size
+    for (size_t size : opts.mSizes)
+    {
+        const std::string ipl = Generate(size, opts.mSeed);
+        // Keep the largest input around if requested
+        if (!opts.mDump.empty() && size == *std::max_element(opts.mSizes.begin(),
+                                                                opts.mSizes.end()))
+        {
+            if (std::FILE * file = std::fopen(opts.mDump.c_str(), "wb"))
+            {
+                std::fwrite(ipl.data(), 1, ipl.size(), file);
+                std::fclose(file);
+            }
+        }
+        // Parse the data
+        Instances inst_list;
+        record(Measure("parse", "", opts.mRepeat, [&](Result & r) {
+            inst_list.clear();
+            ExtractBuffer(ipl.data(), ipl.size(), inst_list, report);
+            r.mInstances = inst_list.size();
+            r.mBytes = ipl.size();
+        }));
+        // Build the spatial index
+        SpatialIndex index;
+        record(Measure("index", "", opts.mRepeat, [&](Result & r) {
+            index.Build(inst_list, 50.0);
+            r.mInstances = inst_list.size();
+            r.mBytes = inst_list.size() * sizeof(Instance);
+        }));
+        // The index must find the same instances as the filter, even with repeated models
+        {
+            SpatialIndex::Query query;
+            query.mModels = {615, 615, 700, 615};
+            Filter models;
+            models.mAllow = query.mModels;
+            Instances found, kept(inst_list);
+            index.Find(query, found);
+            Apply(models, kept);
+            if (found.size() != kept.size())
+            {
+                std::fprintf(stderr, "Unexpected mismatch: index found %zu, filter kept %zu\n",
+                                found.size(), kept.size());
+                ++mismatches;
+            }
+        }
+        // Filter the columns by region, height and models
+        Columns cols;
+        cols.Assign(inst_list);
+        Filter filter;
+        filter.mBox = true;
+        filter.mMin[0] = filter.mMin[1] = -1000.0, filter.mMax[0] = filter.mMax[1] = 1000.0;
+        filter.mMin[2] = -1e9, filter.mMax[2] = 1e9;
+        filter.mRange = true, filter.mLow = 0.0, filter.mHigh = 200.0;
+        filter.mDeny = {615, 700, 1024};
+        std::vector< uint32_t > rows;
+        record(Measure("filter", "cols", opts.mRepeat, [&](Result & r) {
+            rows.clear();
+            Select(cols, filter, rows);
+            r.mInstances = inst_list.size();
+            r.mBytes = inst_list.size() * (sizeof(int32_t) + 3 * sizeof(double));
+        }));
+        // Filter the list in place. Restoring the list is part of the measurement
+        Instances filtered;
+        filtered.reserve(inst_list.size());
+        record(Measure("filter", "list", opts.mRepeat, [&](Result & r) {
+            filtered.assign(inst_list.begin(), inst_list.end());
+            Apply(filter, filtered);
+            r.mInstances = inst_list.size();
+            r.mBytes = inst_list.size() * sizeof(Instance);
+        }));
+        // Format every output mode
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+        {
+            record(Measure("format", names[m], opts.mRepeat, [&](Result & r) {
+                Writer out;
+                Build(modes[m], inst_list, "HideMapObject", out);
+                r.mInstances = inst_list.size();
+                r.mBytes = out.Size();
+            }));
+        }
+    }
+    // Results of stages that disagree are not worth comparing
+    if (mismatches > 0)
+    {
+        return EXIT_FAILURE;
+    }
+    // Save the results, if requested
+    if (!opts.mJson.empty() && !SaveResults(opts.mJson.c_str(), results))
+    {
+        std::fprintf(stderr, "Unable to save the results: %s\n", opts.mJson.c_str());
+        // We're done here
+        return EXIT_FAILURE;
+    }
+    // Compare with previous results, if requested
+    if (!opts.mBaseline.empty())
+    {
+        std::vector< Result > baseline;
+        if (!LoadResults(opts.mBaseline.c_str(), baseline))
+        {
+            std::fprintf(stderr, "Unable to load the baseline: %s\n", opts.mBaseline.c_str());
+            // We're done here
+            return EXIT_FAILURE;
+        }
+        // Number of regressions found and of stages too fast to compare
+        size_t regressions = 0, skipped = 0;
+        for (const auto & r : results)
+        {
+            // Find the same measurement in the baseline
+            auto itr = std::find_if(baseline.begin(), baseline.end(), [&r](const Result & b) {
+                return b.Key() == r.Key();
+            });
+            // Was it measured before?
+            if (itr == baseline.end() || !(itr->mSeconds > 0.0))
+            {
+                continue;
+            }
+            // Is it too fast for the change to be more than noise?
+            else if (itr->mSeconds * 1000.0 < opts.mFloor)
+            {
+                ++skipped;
+                continue;
+            }
+            const double change = (r.mSeconds / itr->mSeconds - 1.0) * 100.0;
+            // Is it slower than tolerated?
+            if (change > opts.mTolerance)
+            {
+                std::printf("REGRESSION %s: %+.1f%% (%.6fs -> %.6fs)\n", r.Key().c_str(),
+                            change, itr->mSeconds, r.mSeconds);
+                ++regressions;
+            }
+        }
+        // Report the outcome
+        std::printf("%zu regression(s) against %s (%zu stage(s) under %.3f ms not compared)\n",
+                    regressions, opts.mBaseline.c_str(), skipped, opts.mFloor);
+        // Regressions are a failure so scripts can catch them
+        if (regressions > 0)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    // Everything went fine
+    return EXIT_SUCCESS;
+}